@@ -39,4 +39,14 @@
 #define PDM_MODULE_BUILD_TIME	MODULE_BUILD_TIME
 #define PDM_MODULE_VERSIONS	MODULE_VERSIONS
 
+/**
+ * @brief Gets the PDM debugfs root directory.
+ *
+ * Adapters create their statistics files below it. debugfs_create_*() accept the
+ * error pointer returned when debugfs is unavailable.
+ *
+ * @return Pointer to the directory, or an error/NULL pointer if debugfs is unavailable.
+ */
+struct dentry *pdm_debugfs_get_dir(void);
+
 #endif /* _PDM_H_ */
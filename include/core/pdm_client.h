@@ -1,6 +1,12 @@
 #ifndef _PDM_CLIENT_H_
 #define _PDM_CLIENT_H_
 
+#include <linux/kfifo.h>
+#include <linux/spinlock.h>
+#include <linux/wait.h>
+
+#include "pdm_client_event.h"
+
 /**
  * @brief PDM Client device name.
  *
@@ -16,6 +22,13 @@
  */
 #define PDM_CLIENT_MINORS			(MINORMASK + 1)
 
+/**
+ * @brief Number of events buffered per PDM Client.
+ *
+ * When the FIFO is full the oldest event is dropped. Must be a power of two.
+ */
+#define PDM_CLIENT_EVENT_FIFO_SIZE		(64)
+
 /**
  * @struct pdm_client_match_data
  * @brief Match data structure for initializing specific types of PDM Client.
@@ -100,6 +113,10 @@ struct pdm_client {
 	struct regmap *map;			/**< PDM Client regmap handle. */
 	union pdm_client_hardware hardware;	 /**< PDM Client hardware information. */
 	void *priv_data;			/**< PDM Client private data. */
+	bool event_enabled;			/**< Whether read() returns queued events */
+	spinlock_t event_lock;			/**< Lock protecting the event FIFO */
+	wait_queue_head_t event_wait;		/**< Wait queue for event readers and poll() */
+	DECLARE_KFIFO(event_fifo, struct pdm_client_event, PDM_CLIENT_EVENT_FIFO_SIZE); /**< Pending events */
 };
 
 /**
@@ -241,6 +258,50 @@ struct device_node *pdm_client_get_of_node(struct pdm_client *client);
  */
 int devm_pdm_client_register(struct pdm_adapter *adapter, struct pdm_client *client);
 
+/**
+ * @brief Enables or disables event reporting on a PDM client.
+ *
+ * Disabling event reporting discards any queued events.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param enable true to enable, false to disable.
+ */
+void pdm_client_event_enable(struct pdm_client *client, bool enable);
+
+/**
+ * @brief Checks whether event reporting is enabled on a PDM client.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @return true if enabled, false otherwise.
+ */
+static inline bool pdm_client_event_enabled(struct pdm_client *client)
+{
+	return client && READ_ONCE(client->event_enabled);
+}
+
+/**
+ * @brief Queues an event on a PDM client and wakes up readers.
+ *
+ * May be called from atomic context. Events are dropped while event reporting is disabled.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param event Pointer to the event to queue.
+ */
+void pdm_client_event_push(struct pdm_client *client, const struct pdm_client_event *event);
+
+/**
+ * @brief Copies queued events to user space.
+ *
+ * Blocks until at least one event is available unless the file was opened with O_NONBLOCK.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param filp File pointer.
+ * @param buf User buffer to copy events into.
+ * @param count Size of the user buffer, must hold at least one event.
+ * @return Number of bytes copied, or negative error code on failure.
+ */
+ssize_t pdm_client_event_read(struct pdm_client *client, struct file *filp, char __user *buf, size_t count);
+
 /**
  * @brief Initializes the PDM Client module.
  *
@@ -0,0 +1,26 @@
+#ifndef _PDM_CLIENT_EVENT_H_
+#define _PDM_CLIENT_EVENT_H_
+
+enum pdm_client_event_type {
+	PDM_CLIENT_EVENT_NULL		= 0x00,
+	PDM_CLIENT_EVENT_THRESHOLD	= 0x01,
+	PDM_CLIENT_EVENT_MOTION		= 0x02,
+	PDM_CLIENT_EVENT_RAMP		= 0x03,
+	PDM_CLIENT_EVENT_PATTERN	= 0x04,
+	PDM_CLIENT_EVENT_SWITCH		= 0x05,	/* Input switch changed, @value is the new state */
+	PDM_CLIENT_EVENT_INVALID	= 0xFFFF
+};
+
+/**
+ * Event record returned by read() on a client with event reporting enabled.
+ * @channel and @code are adapter specific, @timestamp is CLOCK_BOOTTIME in nanoseconds.
+ */
+struct pdm_client_event {
+	unsigned int type;
+	unsigned int channel;
+	unsigned int code;
+	int value;
+	unsigned long long timestamp;
+};
+
+#endif /* _PDM_CLIENT_EVENT_H_ */
@@ -3,8 +3,93 @@
 
 #define PDM_DIMMER_IOC_MAGIC	'd'
 
+/**
+ * Interpolation between the start and the target level of a ramp.
+ */
+enum pdm_dimmer_ramp_curve {
+	PDM_DIMMER_RAMP_LINEAR		= 0x00,
+	PDM_DIMMER_RAMP_EASE_IN		= 0x01,	/* Quadratic, slow start */
+	PDM_DIMMER_RAMP_EASE_OUT	= 0x02,	/* Quadratic, slow end */
+	PDM_DIMMER_RAMP_EASE_IN_OUT	= 0x03,	/* Smoothstep */
+	PDM_DIMMER_RAMP_CURVE_MAX
+};
+
+/**
+ * Result reported in the code of a PDM_CLIENT_EVENT_RAMP or PDM_CLIENT_EVENT_PATTERN event,
+ * the value is the final level. Events are only queued after PDM_DIMMER_EVENT_ENABLE.
+ */
+enum pdm_dimmer_ramp_result {
+	PDM_DIMMER_RAMP_DONE		= 0x00,
+	PDM_DIMMER_RAMP_CANCELLED	= 0x01,
+	PDM_DIMMER_RAMP_FAILED		= 0x02,
+};
+
+/**
+ * Ramp from the current level to @level in @duration_ms, stepping every @tick_us
+ * microseconds, 0 selects the default tick.
+ */
+struct pdm_dimmer_ramp {
+	unsigned int level;
+	unsigned int duration_ms;
+	unsigned int curve;
+	unsigned int tick_us;
+};
+
+#define PDM_DIMMER_GROUP_MAX	8
+#define PDM_DIMMER_GROUP_NONE	0
+
+/**
+ * One member of a group update. @index is the client index, or the member position
+ * inside a DT group. @status is filled in per member.
+ */
+struct pdm_dimmer_group_entry {
+	unsigned int index;
+	unsigned int level;
+	int status;
+};
+
+/**
+ * Levels applied to several dimmers back-to-back. With @group set to PDM_DIMMER_GROUP_NONE
+ * the entries address clients by index, otherwise members of the DT group @group.
+ */
+struct pdm_dimmer_group {
+	unsigned int group;
+	unsigned int count;
+	struct pdm_dimmer_group_entry entries[PDM_DIMMER_GROUP_MAX];
+};
+
+#define PDM_DIMMER_PATTERN_MAX		16
+#define PDM_DIMMER_PATTERN_SMOOTH	(1 << 0)	/* Fade linearly towards the next step */
+
+/**
+ * One step of a pattern, @level is held (or faded from) for @duration_ms.
+ */
+struct pdm_dimmer_pattern_step {
+	unsigned int level;
+	unsigned int duration_ms;
+};
+
+/**
+ * Blink or breathe pattern, the steps are played @repeat times, 0 repeats forever.
+ * @tick_us is the fade step interval of smooth patterns, 0 selects the default.
+ */
+struct pdm_dimmer_pattern {
+	unsigned int count;
+	unsigned int repeat;
+	unsigned int flags;
+	unsigned int tick_us;
+	struct pdm_dimmer_pattern_step steps[PDM_DIMMER_PATTERN_MAX];
+};
+
 /* IOCTL commands */
 #define PDM_DIMMER_SET_BRIGHTNESS		_IOW(PDM_DIMMER_IOC_MAGIC, 0, int *)
 #define PDM_DIMMER_GET_BRIGHTNESS		_IOW(PDM_DIMMER_IOC_MAGIC, 1, int *)
+#define PDM_DIMMER_RAMP				_IOW(PDM_DIMMER_IOC_MAGIC, 2, struct pdm_dimmer_ramp)
+#define PDM_DIMMER_RAMP_CANCEL			_IO(PDM_DIMMER_IOC_MAGIC, 3)
+#define PDM_DIMMER_GROUP_SET			_IOWR(PDM_DIMMER_IOC_MAGIC, 4, struct pdm_dimmer_group)
+#define PDM_DIMMER_PATTERN_SET			_IOW(PDM_DIMMER_IOC_MAGIC, 5, struct pdm_dimmer_pattern)
+#define PDM_DIMMER_PATTERN_CLEAR		_IO(PDM_DIMMER_IOC_MAGIC, 6)
+/* Non-zero switches read() from the help text to ramp and pattern events, zero switches back */
+#define PDM_DIMMER_EVENT_ENABLE			_IOW(PDM_DIMMER_IOC_MAGIC, 7, int)
 
 #endif /* _PDM_DIMMER_IOCTL_H_ */
@@ -8,8 +8,23 @@ struct pdm_nvmem_ioctl_data {
 	unsigned char value;
 };
 
+#define PDM_NVMEM_RECORD_DATA_MAX	(32)
+
+/*
+ * Record store entry, keys are 0~0xFFFF. Setting a record with @len 0 deletes it.
+ */
+struct pdm_nvmem_record {
+	unsigned int key;
+	unsigned int len;
+	unsigned char data[PDM_NVMEM_RECORD_DATA_MAX];
+};
+
 /* IOCTL commands */
 #define PDM_NVMEM_READ_REG	_IOW(PDM_NVMEM_IOC_MAGIC, 0, struct pdm_nvmem_ioctl_data *)
 #define PDM_NVMEM_WRITE_REG	_IOW(PDM_NVMEM_IOC_MAGIC, 1, struct pdm_nvmem_ioctl_data *)
+#define PDM_NVMEM_CACHE_SYNC	_IO(PDM_NVMEM_IOC_MAGIC, 2)	/* Write dirty cached bytes back to the device */
+#define PDM_NVMEM_CACHE_DROP	_IO(PDM_NVMEM_IOC_MAGIC, 3)	/* Discard the cache, next reads hit the device */
+#define PDM_NVMEM_RECORD_GET	_IOWR(PDM_NVMEM_IOC_MAGIC, 4, struct pdm_nvmem_record)
+#define PDM_NVMEM_RECORD_SET	_IOW(PDM_NVMEM_IOC_MAGIC, 5, struct pdm_nvmem_record)
 
 #endif /* _PDM_NVMEM_IOCTL_H_ */
@@ -8,6 +8,14 @@ enum pdm_sensor_type {
 	PDM_SENSOR_TYPE_IR	= 0x01,
 	PDM_SENSOR_TYPE_ALS	= 0x02,
 	PDM_SENSOR_TYPE_PS	= 0x03,
+	/* IMU channels carry the signed 16-bit raw sample, read the value as int */
+	PDM_SENSOR_TYPE_ACCEL_X	= 0x04,
+	PDM_SENSOR_TYPE_ACCEL_Y	= 0x05,
+	PDM_SENSOR_TYPE_ACCEL_Z	= 0x06,
+	PDM_SENSOR_TYPE_TEMP	= 0x07,
+	PDM_SENSOR_TYPE_GYRO_X	= 0x08,
+	PDM_SENSOR_TYPE_GYRO_Y	= 0x09,
+	PDM_SENSOR_TYPE_GYRO_Z	= 0x0A,
 	PDM_SENSOR_TYPE_INVALID	= 0xFFFF
 };
 
@@ -16,7 +24,104 @@ struct pdm_sensor_ioctl_data {
 	unsigned int value;
 };
 
+/*
+ * Sample with the CLOCK_BOOTTIME time, in nanoseconds, at which the bus transfer
+ * or interrupt that produced it happened.
+ */
+struct pdm_sensor_sample {
+	enum pdm_sensor_type type;
+	unsigned int value;
+	unsigned long long timestamp;
+};
+
+#define PDM_SENSOR_GROUP_MAX	(8)
+
+/*
+ * Group trigger: the channels are sampled back-to-back in a single kernel pass.
+ * @index: client index, N for /dev/pdm_client/pdm_sensor.N
+ * @status: 0 or the negative errno of this entry, the other entries are still sampled
+ */
+struct pdm_sensor_group_entry {
+	unsigned int index;
+	enum pdm_sensor_type type;
+	unsigned int value;
+	int status;
+	unsigned long long timestamp;
+};
+
+struct pdm_sensor_group_trigger {
+	unsigned int count;
+	struct pdm_sensor_group_entry entries[PDM_SENSOR_GROUP_MAX];
+};
+
+/* Operating modes, the *_ONCE modes run a single conversion per read */
+enum pdm_sensor_mode {
+	PDM_SENSOR_MODE_POWER_DOWN	= 0x00,
+	PDM_SENSOR_MODE_ALS		= 0x01,
+	PDM_SENSOR_MODE_PS_IR		= 0x02,
+	PDM_SENSOR_MODE_ALL		= 0x03,
+	PDM_SENSOR_MODE_ALS_ONCE	= 0x05,
+	PDM_SENSOR_MODE_PS_IR_ONCE	= 0x06,
+	PDM_SENSOR_MODE_ALL_ONCE	= 0x07,
+};
+
+/* Band reported in the code field of PDM_CLIENT_EVENT_THRESHOLD events */
+enum pdm_sensor_threshold_zone {
+	PDM_SENSOR_ZONE_INSIDE	= 0x00,
+	PDM_SENSOR_ZONE_BELOW	= 0x01,
+	PDM_SENSOR_ZONE_ABOVE	= 0x02,
+};
+
+/*
+ * A channel is ABOVE once it exceeds @high and stays there until it drops below
+ * @high - @hysteresis; BELOW works the same way around @low + @hysteresis.
+ */
+struct pdm_sensor_threshold {
+	enum pdm_sensor_type type;
+	unsigned int enable;
+	unsigned int low;
+	unsigned int high;
+	unsigned int hysteresis;
+};
+
+/*
+ * Wake-on-motion: the sensor idles in a low-power mode and raises a
+ * PDM_CLIENT_EVENT_MOTION event (code = axis mask, X is bit 0) when the
+ * sample-to-sample change exceeds @threshold_mg on any axis.
+ * @wake_div selects the wake-up rate, 1 kHz / (1 + @wake_div).
+ */
+struct pdm_sensor_wom_config {
+	unsigned int enable;
+	unsigned int threshold_mg;
+	unsigned int wake_div;
+};
+
+/*
+ * IMU measurement configuration.
+ * @sample_div: output data rate is 1 kHz / (1 + @sample_div) with @gyro_dlpf 1~6, 0~255
+ * @gyro_range: 0: +-250 dps, 1: +-500 dps, 2: +-1000 dps, 3: +-2000 dps
+ * @accel_range: 0: +-2 g, 1: +-4 g, 2: +-8 g, 3: +-16 g
+ * @gyro_dlpf: gyro low-pass filter setting (DLPF_CFG), 0~7
+ * @accel_dlpf: accelerometer low-pass filter setting (A_DLPF_CFG), 0~7
+ */
+struct pdm_sensor_imu_config {
+	unsigned int sample_div;
+	unsigned int gyro_range;
+	unsigned int accel_range;
+	unsigned int gyro_dlpf;
+	unsigned int accel_dlpf;
+};
+
 /* IOCTL commands */
-#define PDM_SENSOR_READ_REG	_IOW(PDM_SENSOR_IOC_MAGIC, 0, struct pdm_sensor_ioctl_data *)
+#define PDM_SENSOR_READ_REG		_IOW(PDM_SENSOR_IOC_MAGIC, 0, struct pdm_sensor_ioctl_data *)
+#define PDM_SENSOR_SET_THRESHOLD	_IOW(PDM_SENSOR_IOC_MAGIC, 1, struct pdm_sensor_threshold)
+#define PDM_SENSOR_GET_THRESHOLD	_IOWR(PDM_SENSOR_IOC_MAGIC, 2, struct pdm_sensor_threshold)
+#define PDM_SENSOR_SET_WOM		_IOW(PDM_SENSOR_IOC_MAGIC, 3, struct pdm_sensor_wom_config)
+#define PDM_SENSOR_SET_IMU_CONFIG	_IOW(PDM_SENSOR_IOC_MAGIC, 4, struct pdm_sensor_imu_config)
+#define PDM_SENSOR_GET_IMU_CONFIG	_IOR(PDM_SENSOR_IOC_MAGIC, 5, struct pdm_sensor_imu_config)
+#define PDM_SENSOR_SET_MODE		_IOW(PDM_SENSOR_IOC_MAGIC, 6, unsigned int)
+#define PDM_SENSOR_GET_MODE		_IOR(PDM_SENSOR_IOC_MAGIC, 7, unsigned int)
+#define PDM_SENSOR_READ_SAMPLE		_IOWR(PDM_SENSOR_IOC_MAGIC, 8, struct pdm_sensor_sample)
+#define PDM_SENSOR_GROUP_TRIGGER	_IOWR(PDM_SENSOR_IOC_MAGIC, 9, struct pdm_sensor_group_trigger)
 
 #endif /* _PDM_SENSOR_IOCTL_H_ */
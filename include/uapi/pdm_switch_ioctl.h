@@ -6,8 +6,40 @@
 
 #define PDM_SWITCH_IOC_MAGIC	's'
 
+#define PDM_SWITCH_MULTI_MAX	32
+
+/**
+ * One switch of a multi-switch request, addressed by client index.
+ * @state is the input for set and the output for get, @status is filled in per switch.
+ */
+struct pdm_switch_multi_entry {
+	unsigned int index;
+	int state;
+	int status;
+};
+
+struct pdm_switch_multi {
+	unsigned int count;
+	struct pdm_switch_multi_entry entries[PDM_SWITCH_MULTI_MAX];
+};
+
+/**
+ * Pulse train: the switch is turned on for @on_us, then off for @off_us, @count times.
+ * @count 0 pulses until cancelled. The train runs in the kernel, the ioctl returns at once.
+ */
+struct pdm_switch_pulse {
+	unsigned int on_us;
+	unsigned int off_us;
+	unsigned int count;
+};
+
 /* IOCTL commands */
 #define PDM_SWITCH_SET_STATE		_IOW(PDM_SWITCH_IOC_MAGIC, 0, int *)
 #define PDM_SWITCH_GET_STATE		_IOW(PDM_SWITCH_IOC_MAGIC, 1, int *)
+#define PDM_SWITCH_MULTI_SET		_IOWR(PDM_SWITCH_IOC_MAGIC, 2, struct pdm_switch_multi)
+#define PDM_SWITCH_MULTI_GET		_IOWR(PDM_SWITCH_IOC_MAGIC, 3, struct pdm_switch_multi)
+#define PDM_SWITCH_PULSE		_IOW(PDM_SWITCH_IOC_MAGIC, 4, struct pdm_switch_pulse)
+#define PDM_SWITCH_PULSE_CANCEL		_IO(PDM_SWITCH_IOC_MAGIC, 5)
+#define PDM_SWITCH_FLUSH		_IO(PDM_SWITCH_IOC_MAGIC, 6)	/* Wait for deferred writes */
 
 #endif /* _PDM_SWITCH_IOCTL_H_ */
@@ -1,4 +1,5 @@
 #include <linux/compat.h>
+#include <linux/poll.h>
 #include "pdm.h"
 
 /**
@@ -140,6 +141,131 @@ static long pdm_client_fops_default_compat_ioctl(struct file *filp, unsigned int
 	return filp->f_op->unlocked_ioctl(filp, cmd, arg);
 }
 
+/**
+ * @brief Default poll function.
+ *
+ * Reports the client readable when events are queued.
+ *
+ * @param filp Pointer to the file structure.
+ * @param wait Poll table.
+ *
+ * @return Poll event mask.
+ */
+static __poll_t pdm_client_fops_default_poll(struct file *filp, poll_table *wait)
+{
+	struct pdm_client *client = filp->private_data;
+
+	if (!client) {
+		return EPOLLERR;
+	}
+
+	poll_wait(filp, &client->event_wait, wait);
+	if (!kfifo_is_empty(&client->event_fifo)) {
+		return EPOLLIN | EPOLLRDNORM;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Enables or disables event reporting on a PDM client.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param enable true to enable, false to disable.
+ */
+void pdm_client_event_enable(struct pdm_client *client, bool enable)
+{
+	unsigned long flags;
+
+	if (!client) {
+		return;
+	}
+
+	spin_lock_irqsave(&client->event_lock, flags);
+	WRITE_ONCE(client->event_enabled, enable);
+	if (!enable) {
+		kfifo_reset(&client->event_fifo);
+	}
+	spin_unlock_irqrestore(&client->event_lock, flags);
+
+	wake_up_interruptible(&client->event_wait);
+}
+
+/**
+ * @brief Queues an event on a PDM client and wakes up readers.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param event Pointer to the event to queue.
+ */
+void pdm_client_event_push(struct pdm_client *client, const struct pdm_client_event *event)
+{
+	unsigned long flags;
+
+	if (!client || !event) {
+		return;
+	}
+
+	spin_lock_irqsave(&client->event_lock, flags);
+	if (!client->event_enabled) {
+		spin_unlock_irqrestore(&client->event_lock, flags);
+		return;
+	}
+	if (kfifo_is_full(&client->event_fifo)) {
+		kfifo_skip(&client->event_fifo);
+	}
+	kfifo_put(&client->event_fifo, *event);
+	spin_unlock_irqrestore(&client->event_lock, flags);
+
+	wake_up_interruptible_poll(&client->event_wait, EPOLLIN | EPOLLRDNORM);
+}
+
+/**
+ * @brief Copies queued events to user space.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param filp File pointer.
+ * @param buf User buffer to copy events into.
+ * @param count Size of the user buffer.
+ * @return Number of bytes copied, or negative error code on failure.
+ */
+ssize_t pdm_client_event_read(struct pdm_client *client, struct file *filp, char __user *buf, size_t count)
+{
+	struct pdm_client_event event;
+	ssize_t copied = 0;
+	int status;
+
+	if (!client || count < sizeof(event)) {
+		return -EINVAL;
+	}
+
+	while (copied + sizeof(event) <= count) {
+		if (!kfifo_out_spinlocked(&client->event_fifo, &event, 1, &client->event_lock)) {
+			if (copied) {
+				break;
+			}
+			if (filp->f_flags & O_NONBLOCK) {
+				return -EAGAIN;
+			}
+			status = wait_event_interruptible(client->event_wait,
+							  !kfifo_is_empty(&client->event_fifo) ||
+							  !pdm_client_event_enabled(client));
+			if (status) {
+				return status;
+			}
+			if (!pdm_client_event_enabled(client)) {
+				return 0;
+			}
+			continue;
+		}
+
+		if (copy_to_user(buf + copied, &event, sizeof(event))) {
+			return copied ? copied : -EFAULT;
+		}
+		copied += sizeof(event);
+	}
+
+	return copied;
+}
 
 /**
  * @brief Registers a PDM Client character device.
@@ -176,6 +302,7 @@ static int pdm_client_device_register(struct pdm_client *client)
 	client->fops.write = pdm_client_fops_default_write;
 	client->fops.unlocked_ioctl = pdm_client_fops_default_ioctl;
 	client->fops.compat_ioctl = pdm_client_fops_default_compat_ioctl;
+	client->fops.poll = pdm_client_fops_default_poll;
 	cdev_init(&client->cdev, &client->fops);
 
 	status = cdev_device_add(&client->cdev, &client->dev);
@@ -342,10 +469,14 @@ struct pdm_client *devm_pdm_client_alloc(struct pdm_device *pdmdev, unsigned int
 	client->dev.parent = &pdmdev->dev;
 	device_initialize(&client->dev);
 
+	spin_lock_init(&client->event_lock);
+	init_waitqueue_head(&client->event_wait);
+	INIT_KFIFO(client->event_fifo);
+
 	pdmdev->client = client;
 	client->pdmdev = pdmdev;
 	if (data_size) {
-		pdm_client_set_private_data(client, (void *)(client + client_size));
+		pdm_client_set_private_data(client, (void *)client + client_size);
 	}
 
 	if (devm_add_action_or_reset(&pdmdev->dev, devm_pdm_client_free, client)) {
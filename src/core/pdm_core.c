@@ -16,6 +16,16 @@ static struct list_head pdm_core_component_list;
  */
 static struct dentry *pdm_debugfs_dir;
 
+/**
+ * @brief Gets the PDM debugfs root directory.
+ *
+ * @return Pointer to the directory, or an error/NULL pointer if debugfs is unavailable.
+ */
+struct dentry *pdm_debugfs_get_dir(void)
+{
+	return pdm_debugfs_dir;
+}
+
 /**
  * @brief Initializes the PDM debugging filesystem.
  *
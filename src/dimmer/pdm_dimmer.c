@@ -1,3 +1,5 @@
+#include <linux/math64.h>
+
 #include "pdm.h"
 #include "pdm_adapter_priv.h"
 #include "pdm_dimmer_ioctl.h"
@@ -5,11 +7,436 @@
 
 static struct pdm_adapter *dimmer_adapter = NULL;
 
+/**
+ * @brief Serializes group updates, keeping the member lock order consistent.
+ */
+static DEFINE_MUTEX(pdm_dimmer_group_lock);
+
+/**
+ * @brief Maps the ramp progress through the ramp curve, both in 1/65536 units.
+ */
+static u64 pdm_dimmer_ramp_curve(unsigned int curve, u64 p)
+{
+	const u64 one = 1 << 16;
+	u64 p2, p3;
+
+	switch (curve) {
+		case PDM_DIMMER_RAMP_EASE_IN:
+			return (p * p) >> 16;
+		case PDM_DIMMER_RAMP_EASE_OUT:
+			return one - (((one - p) * (one - p)) >> 16);
+		case PDM_DIMMER_RAMP_EASE_IN_OUT:
+			p2 = (p * p) >> 16;
+			p3 = (p2 * p) >> 16;
+			return 3 * p2 - 2 * p3;
+		case PDM_DIMMER_RAMP_LINEAR:
+		default:
+			return p;
+	}
+}
+
+/**
+ * @brief Returns the level the ramp should be at after @elapsed_ns.
+ */
+static unsigned int pdm_dimmer_ramp_level(struct pdm_dimmer_ramp_state *ramp, u64 elapsed_ns)
+{
+	u64 progress;
+	s64 delta;
+
+	progress = pdm_dimmer_ramp_curve(ramp->curve, div64_u64(elapsed_ns << 16, ramp->duration_ns));
+	delta = (s64)ramp->to - (s64)ramp->from;
+
+	return ramp->from + (int)div_s64(delta * (s64)progress + (delta < 0 ? -(1 << 15) : (1 << 15)), 1 << 16);
+}
+
+/**
+ * @brief Reports the end of a ramp or pattern on the client fd.
+ */
+static void pdm_dimmer_report(struct pdm_dimmer_priv *dimmer_priv, unsigned int type,
+			      unsigned int result, unsigned int level)
+{
+	struct pdm_client_event event;
+
+	memset(&event, 0, sizeof(event));
+	event.type = type;
+	event.code = result;
+	event.value = level;
+	event.timestamp = ktime_get_boottime_ns();
+	pdm_client_event_push(dimmer_priv->client, &event);
+}
+
+/**
+ * @brief Reports the end of a ramp. Called with dimmer_priv->lock held.
+ */
+static void pdm_dimmer_ramp_report(struct pdm_dimmer_priv *dimmer_priv, unsigned int result)
+{
+	pdm_dimmer_report(dimmer_priv, PDM_CLIENT_EVENT_RAMP, result, dimmer_priv->ramp.level);
+}
+
+/**
+ * @brief Ramp tick, hands the step over to the work item.
+ */
+static enum hrtimer_restart pdm_dimmer_ramp_timer_func(struct hrtimer *timer)
+{
+	struct pdm_dimmer_ramp_state *ramp = container_of(timer, struct pdm_dimmer_ramp_state, timer);
+
+	if (!READ_ONCE(ramp->active)) {
+		return HRTIMER_NORESTART;
+	}
+
+	/* Still pending when the previous step is late, the next step catches up */
+	queue_work(system_highpri_wq, &ramp->work);
+	hrtimer_forward_now(timer, ramp->tick);
+	return HRTIMER_RESTART;
+}
+
+/**
+ * @brief Applies the level of the current ramp step.
+ */
+static void pdm_dimmer_ramp_work_func(struct work_struct *work)
+{
+	struct pdm_dimmer_ramp_state *ramp = container_of(work, struct pdm_dimmer_ramp_state, work);
+	struct pdm_dimmer_priv *dimmer_priv = container_of(ramp, struct pdm_dimmer_priv, ramp);
+	unsigned int level;
+	u64 elapsed;
+	bool done;
+	int status;
+
+	mutex_lock(&dimmer_priv->lock);
+	if (!ramp->active) {
+		goto unlock;
+	}
+
+	elapsed = ktime_to_ns(ktime_sub(ktime_get(), ramp->start));
+	done = elapsed >= ramp->duration_ns;
+	level = done ? ramp->to : pdm_dimmer_ramp_level(ramp, elapsed);
+
+	if (level != ramp->level) {
+		status = dimmer_priv->set_level(dimmer_priv->client, level);
+		if (status) {
+			OSA_ERROR("Ramp step to level %u failed, status: %d\n", level, status);
+			WRITE_ONCE(ramp->active, false);
+			pdm_dimmer_ramp_report(dimmer_priv, PDM_DIMMER_RAMP_FAILED);
+			goto unlock;
+		}
+		ramp->level = level;
+	}
+
+	if (done) {
+		WRITE_ONCE(ramp->active, false);
+		pdm_dimmer_ramp_report(dimmer_priv, PDM_DIMMER_RAMP_DONE);
+	}
+
+unlock:
+	mutex_unlock(&dimmer_priv->lock);
+}
+
+/**
+ * @brief Stops a running ramp, the level stays where the last step left it.
+ *
+ * Must be called with dimmer_priv->ramp_lock held.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param report Report the cancellation on the client fd.
+ */
+static void pdm_dimmer_ramp_stop(struct pdm_client *client, bool report)
+{
+	struct pdm_dimmer_priv *dimmer_priv = pdm_client_get_private_data(client);
+	struct pdm_dimmer_ramp_state *ramp = &dimmer_priv->ramp;
+
+	mutex_lock(&dimmer_priv->lock);
+	if (ramp->active) {
+		WRITE_ONCE(ramp->active, false);
+		if (report) {
+			pdm_dimmer_ramp_report(dimmer_priv, PDM_DIMMER_RAMP_CANCELLED);
+		}
+	}
+	mutex_unlock(&dimmer_priv->lock);
+
+	hrtimer_cancel(&ramp->timer);
+	cancel_work_sync(&ramp->work);
+}
+
+/**
+ * @brief Pattern timer, hands the step over to the work item.
+ */
+static enum hrtimer_restart pdm_dimmer_pattern_timer_func(struct hrtimer *timer)
+{
+	struct pdm_dimmer_pattern_state *pattern = container_of(timer, struct pdm_dimmer_pattern_state, timer);
+
+	queue_work(system_highpri_wq, &pattern->work);
+	return HRTIMER_NORESTART;
+}
+
+/**
+ * @brief Advances the pattern to the step due now and applies its level.
+ */
+static void pdm_dimmer_pattern_work_func(struct work_struct *work)
+{
+	struct pdm_dimmer_pattern_state *pattern = container_of(work, struct pdm_dimmer_pattern_state, work);
+	struct pdm_dimmer_priv *dimmer_priv = container_of(pattern, struct pdm_dimmer_priv, pattern);
+	const struct pdm_dimmer_pattern_step *step, *next;
+	ktime_t now, expires;
+	s64 elapsed, duration;
+	unsigned int level;
+	int status;
+
+	mutex_lock(&dimmer_priv->lock);
+	if (!pattern->active || pattern->hw) {
+		goto unlock;
+	}
+
+	now = ktime_get();
+	while (ktime_compare(now, pattern->step_end) >= 0) {
+		if (++pattern->step == pattern->pattern.count) {
+			pattern->step = 0;
+			if (pattern->pattern.repeat && ++pattern->cycle >= pattern->pattern.repeat) {
+				pattern->active = false;
+				pdm_dimmer_report(dimmer_priv, PDM_CLIENT_EVENT_PATTERN, PDM_DIMMER_RAMP_DONE, pattern->level);
+				goto unlock;
+			}
+		}
+		pattern->step_start = pattern->step_end;
+		pattern->step_end = ktime_add_ms(pattern->step_end, pattern->pattern.steps[pattern->step].duration_ms);
+	}
+
+	step = &pattern->pattern.steps[pattern->step];
+	next = &pattern->pattern.steps[(pattern->step + 1) % pattern->pattern.count];
+	level = step->level;
+	expires = pattern->step_end;
+
+	if ((pattern->pattern.flags & PDM_DIMMER_PATTERN_SMOOTH) && next->level != step->level) {
+		elapsed = ktime_to_ns(ktime_sub(now, pattern->step_start));
+		duration = ktime_to_ns(ktime_sub(pattern->step_end, pattern->step_start));
+		level = step->level + (int)div64_s64(((s64)next->level - step->level) * elapsed, duration);
+		expires = ktime_add(now, pattern->tick);
+		if (ktime_after(expires, pattern->step_end)) {
+			expires = pattern->step_end;
+		}
+	}
+
+	if (level != pattern->level) {
+		status = dimmer_priv->set_level(dimmer_priv->client, level);
+		if (status) {
+			OSA_ERROR("Pattern step to level %u failed, status: %d\n", level, status);
+			pattern->active = false;
+			pdm_dimmer_report(dimmer_priv, PDM_CLIENT_EVENT_PATTERN, PDM_DIMMER_RAMP_FAILED, pattern->level);
+			goto unlock;
+		}
+		pattern->level = level;
+	}
+
+	hrtimer_start(&pattern->timer, expires, HRTIMER_MODE_ABS);
+
+unlock:
+	mutex_unlock(&dimmer_priv->lock);
+}
+
+/**
+ * @brief Stops a running pattern, the level stays at the last applied step.
+ *
+ * Must be called with dimmer_priv->ramp_lock held.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param report Report the cancellation on the client fd.
+ */
+static void pdm_dimmer_pattern_stop(struct pdm_client *client, bool report)
+{
+	struct pdm_dimmer_priv *dimmer_priv = pdm_client_get_private_data(client);
+	struct pdm_dimmer_pattern_state *pattern = &dimmer_priv->pattern;
+
+	mutex_lock(&dimmer_priv->lock);
+	if (pattern->active) {
+		pattern->active = false;
+		if (pattern->hw && dimmer_priv->pattern_clear) {
+			dimmer_priv->pattern_clear(client);
+		}
+		if (report) {
+			pdm_dimmer_report(dimmer_priv, PDM_CLIENT_EVENT_PATTERN, PDM_DIMMER_RAMP_CANCELLED, pattern->level);
+		}
+	}
+	mutex_unlock(&dimmer_priv->lock);
+
+	hrtimer_cancel(&pattern->timer);
+	cancel_work_sync(&pattern->work);
+}
+
+/**
+ * @brief Stops ramps and patterns before the level is changed by other means.
+ *
+ * Must be called with dimmer_priv->ramp_lock held.
+ */
+static void pdm_dimmer_effects_stop(struct pdm_client *client, bool report)
+{
+	pdm_dimmer_ramp_stop(client, report);
+	pdm_dimmer_pattern_stop(client, report);
+}
+
+/**
+ * @brief Starts a ramp from the current level, replacing any ramp in progress.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param args Ramp parameters from user space.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_dimmer_ramp_start(struct pdm_client *client, const struct pdm_dimmer_ramp *args)
+{
+	struct pdm_dimmer_priv *dimmer_priv = pdm_client_get_private_data(client);
+	struct pdm_dimmer_ramp_state *ramp = &dimmer_priv->ramp;
+	unsigned int tick_us = args->tick_us ? args->tick_us : PDM_DIMMER_RAMP_TICK_US;
+	unsigned int level;
+	int status;
+
+	if (!dimmer_priv->set_level || !dimmer_priv->get_level) {
+		OSA_ERROR("ramp not supported\n");
+		return -ENOTSUPP;
+	}
+
+	if (args->level > dimmer_priv->max_level || args->curve >= PDM_DIMMER_RAMP_CURVE_MAX
+		|| args->duration_ms > PDM_DIMMER_RAMP_DURATION_MAX_MS || tick_us < PDM_DIMMER_RAMP_TICK_MIN_US) {
+		OSA_ERROR("Invalid ramp: level %u, duration %u ms, curve %u, tick %u us\n",
+			  args->level, args->duration_ms, args->curve, tick_us);
+		return -EINVAL;
+	}
+
+	mutex_lock(&dimmer_priv->ramp_lock);
+	pdm_dimmer_effects_stop(client, true);
+
+	mutex_lock(&dimmer_priv->lock);
+	status = dimmer_priv->get_level(client, &level);
+	if (status) {
+		OSA_ERROR("Failed to get ramp start level, status: %d\n", status);
+		goto unlock;
+	}
+
+	ramp->from = level;
+	ramp->level = level;
+	ramp->to = args->level;
+	ramp->curve = args->curve;
+	ramp->duration_ns = (u64)args->duration_ms * NSEC_PER_MSEC;
+	ramp->tick = us_to_ktime(tick_us);
+	ramp->start = ktime_get();
+	WRITE_ONCE(ramp->active, true);
+
+	if (!ramp->duration_ns) {
+		mutex_unlock(&dimmer_priv->lock);
+		queue_work(system_highpri_wq, &ramp->work);
+		goto unlock_ramp;
+	}
+	hrtimer_start(&ramp->timer, ramp->tick, HRTIMER_MODE_REL);
+
+unlock:
+	mutex_unlock(&dimmer_priv->lock);
+unlock_ramp:
+	mutex_unlock(&dimmer_priv->ramp_lock);
+	return status;
+}
+
+/**
+ * @brief Starts playing a pattern, replacing any ramp or pattern in progress.
+ *
+ * The backend plays the pattern when it supports hardware patterns, otherwise it is played
+ * by the software player, which only wakes up at step boundaries and fade ticks.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param args Pattern from user space.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_dimmer_pattern_start(struct pdm_client *client, const struct pdm_dimmer_pattern *args)
+{
+	struct pdm_dimmer_priv *dimmer_priv = pdm_client_get_private_data(client);
+	struct pdm_dimmer_pattern_state *pattern = &dimmer_priv->pattern;
+	unsigned int tick_us = args->tick_us ? args->tick_us : PDM_DIMMER_RAMP_TICK_US;
+	unsigned int i;
+	int status = 0;
+
+	if (!dimmer_priv->set_level) {
+		OSA_ERROR("pattern not supported\n");
+		return -ENOTSUPP;
+	}
+
+	if (!args->count || args->count > PDM_DIMMER_PATTERN_MAX || tick_us < PDM_DIMMER_RAMP_TICK_MIN_US
+		|| (args->flags & ~PDM_DIMMER_PATTERN_SMOOTH)) {
+		OSA_ERROR("Invalid pattern: %u steps, flags 0x%x, tick %u us\n", args->count, args->flags, tick_us);
+		return -EINVAL;
+	}
+
+	for (i = 0; i < args->count; i++) {
+		if (args->steps[i].level > dimmer_priv->max_level || !args->steps[i].duration_ms
+			|| args->steps[i].duration_ms > PDM_DIMMER_RAMP_DURATION_MAX_MS) {
+			OSA_ERROR("Invalid pattern step %u: level %u, duration %u ms\n", i,
+				  args->steps[i].level, args->steps[i].duration_ms);
+			return -EINVAL;
+		}
+	}
+
+	mutex_lock(&dimmer_priv->ramp_lock);
+	pdm_dimmer_effects_stop(client, true);
+
+	mutex_lock(&dimmer_priv->lock);
+	pattern->pattern = *args;
+	pattern->tick = us_to_ktime(tick_us);
+	pattern->step = 0;
+	pattern->cycle = 0;
+	pattern->hw = false;
+
+	if (dimmer_priv->pattern_set) {
+		status = dimmer_priv->pattern_set(client, args);
+		if (!status) {
+			pattern->hw = true;
+			pattern->level = args->steps[0].level;
+			pattern->active = true;
+			goto unlock;
+		}
+		if (status != -EOPNOTSUPP) {
+			OSA_ERROR("Hardware pattern failed, status: %d\n", status);
+			goto unlock;
+		}
+		status = 0;
+	}
+
+	/* The first step is applied by the work item right away */
+	if (!dimmer_priv->get_level || dimmer_priv->get_level(client, &pattern->level)) {
+		pattern->level = UINT_MAX;
+	}
+	pattern->step_start = ktime_get();
+	pattern->step_end = ktime_add_ms(pattern->step_start, args->steps[0].duration_ms);
+	pattern->active = true;
+	queue_work(system_highpri_wq, &pattern->work);
+
+unlock:
+	mutex_unlock(&dimmer_priv->lock);
+	mutex_unlock(&dimmer_priv->ramp_lock);
+	return status;
+}
+
+/**
+ * @brief Sets up the ramp engine and the pattern player of a client.
+ */
+static void pdm_dimmer_ramp_init(struct pdm_dimmer_priv *dimmer_priv)
+{
+	struct pdm_dimmer_ramp_state *ramp = &dimmer_priv->ramp;
+	struct pdm_dimmer_pattern_state *pattern = &dimmer_priv->pattern;
+
+	mutex_init(&dimmer_priv->ramp_lock);
+	INIT_WORK(&ramp->work, pdm_dimmer_ramp_work_func);
+	INIT_WORK(&pattern->work, pdm_dimmer_pattern_work_func);
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 13, 0)
+	hrtimer_init(&ramp->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	ramp->timer.function = pdm_dimmer_ramp_timer_func;
+	hrtimer_init(&pattern->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	pattern->timer.function = pdm_dimmer_pattern_timer_func;
+#else
+	hrtimer_setup(&ramp->timer, pdm_dimmer_ramp_timer_func, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	hrtimer_setup(&pattern->timer, pdm_dimmer_pattern_timer_func, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+#endif
+}
+
 /**
  * @brief Sets the level of a specified PDM DIMMER device.
  *
  * @param client Pointer to the PDM client structure.
- * @param level (0-255).
+ * @param level (0-max_level).
  * @return Returns 0 on success; negative error code on failure.
  */
 static int pdm_dimmer_set_level(struct pdm_client *client, unsigned int level)
@@ -22,23 +449,30 @@ static int pdm_dimmer_set_level(struct pdm_client *client, unsigned int level)
 		return -EINVAL;
 	}
 
-	if (level > PDM_DIMMER_MAX_LEVEL_VALUE) {
-		OSA_ERROR("Invalid level: %u\n", level);
-		return -EINVAL;
-	}
-
 	dimmer_priv = pdm_client_get_private_data(client);
 	if (!dimmer_priv) {
 		OSA_ERROR("Get PDM Client Device Data Failed\n");
 		return -ENOMEM;
 	}
 
+	if (level > dimmer_priv->max_level) {
+		OSA_ERROR("Invalid level: %u\n", level);
+		return -EINVAL;
+	}
+
 	if (!dimmer_priv->set_level) {
 		OSA_ERROR("set_level not supported\n");
 		return -ENOTSUPP;
 	}
 
+	/* An explicit level overrides a fade or pattern in progress */
+	mutex_lock(&dimmer_priv->ramp_lock);
+	pdm_dimmer_effects_stop(client, true);
+	mutex_unlock(&dimmer_priv->ramp_lock);
+
+	mutex_lock(&dimmer_priv->lock);
 	status = dimmer_priv->set_level(client, level);
+	mutex_unlock(&dimmer_priv->lock);
 	if (status) {
 		OSA_ERROR("PDM Dimmer set_level failed, status: %d\n", status);
 		return status;
@@ -75,7 +509,9 @@ static int pdm_dimmer_get_level(struct pdm_client *client, unsigned int *level)
 		return -ENOTSUPP;
 	}
 
+	mutex_lock(&dimmer_priv->lock);
 	status = dimmer_priv->get_level(client, level);
+	mutex_unlock(&dimmer_priv->lock);
 	if (status) {
 		OSA_ERROR("PDM Dimmer get_level failed, status: %d\n", status);
 		return status;
@@ -86,6 +522,111 @@ static int pdm_dimmer_get_level(struct pdm_client *client, unsigned int *level)
 	return 0;
 }
 
+/**
+ * @brief Returns the dimmer a group entry refers to. Called with the client list lock held.
+ */
+static struct pdm_client *pdm_dimmer_group_find(unsigned int group, unsigned int index)
+{
+	struct pdm_dimmer_priv *dimmer_priv;
+	struct pdm_client *client;
+
+	list_for_each_entry(client, &dimmer_adapter->client_list, entry) {
+		dimmer_priv = pdm_client_get_private_data(client);
+		if (group == PDM_DIMMER_GROUP_NONE) {
+			if (client->index == index) {
+				return client;
+			}
+		} else if (dimmer_priv->group == group && dimmer_priv->group_pos == index) {
+			return client;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Applies the levels of a group back-to-back.
+ *
+ * All members are locked and their new states computed before the first one is applied,
+ * so the hardware updates follow each other without lookups or calculations in between.
+ * Members with an error keep their level, the others are still updated.
+ *
+ * @param group Group description, per-entry status is filled in.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_dimmer_group_set(struct pdm_dimmer_group *group)
+{
+	struct pdm_client *clients[PDM_DIMMER_GROUP_MAX];
+	struct pdm_dimmer_priv *dimmer_priv;
+	struct pdm_dimmer_group_entry *entry;
+	unsigned int i, j;
+
+	if (!group->count || group->count > PDM_DIMMER_GROUP_MAX) {
+		OSA_ERROR("Invalid group size: %u\n", group->count);
+		return -EINVAL;
+	}
+
+	mutex_lock(&dimmer_adapter->client_list_mutex_lock);
+	for (i = 0; i < group->count; i++) {
+		entry = &group->entries[i];
+		clients[i] = pdm_dimmer_group_find(group->group, entry->index);
+		entry->status = clients[i] ? 0 : -ENODEV;
+		for (j = 0; j < i && clients[i]; j++) {
+			if (clients[j] == clients[i]) {
+				entry->status = -EINVAL;
+			}
+		}
+		if (entry->status) {
+			clients[i] = NULL;
+			continue;
+		}
+
+		/* A fade or pattern in progress would overwrite the scene */
+		dimmer_priv = pdm_client_get_private_data(clients[i]);
+		mutex_lock(&dimmer_priv->ramp_lock);
+		pdm_dimmer_effects_stop(clients[i], true);
+		mutex_unlock(&dimmer_priv->ramp_lock);
+	}
+
+	mutex_lock(&pdm_dimmer_group_lock);
+	for (i = 0; i < group->count; i++) {
+		if (!clients[i]) {
+			continue;
+		}
+		dimmer_priv = pdm_client_get_private_data(clients[i]);
+		mutex_lock_nested(&dimmer_priv->lock, i);
+		if (group->entries[i].level > dimmer_priv->max_level) {
+			group->entries[i].status = -EINVAL;
+		} else if (dimmer_priv->prepare_level) {
+			group->entries[i].status = dimmer_priv->prepare_level(clients[i], group->entries[i].level);
+		} else if (!dimmer_priv->set_level) {
+			group->entries[i].status = -ENOTSUPP;
+		}
+	}
+
+	for (i = 0; i < group->count; i++) {
+		if (!clients[i]) {
+			continue;
+		}
+		dimmer_priv = pdm_client_get_private_data(clients[i]);
+		if (!group->entries[i].status) {
+			group->entries[i].status = dimmer_priv->prepare_level ? dimmer_priv->commit_level(clients[i])
+					: dimmer_priv->set_level(clients[i], group->entries[i].level);
+		}
+	}
+
+	for (i = group->count; i-- > 0;) {
+		if (clients[i]) {
+			dimmer_priv = pdm_client_get_private_data(clients[i]);
+			mutex_unlock(&dimmer_priv->lock);
+		}
+	}
+	mutex_unlock(&pdm_dimmer_group_lock);
+	mutex_unlock(&dimmer_adapter->client_list_mutex_lock);
+
+	return 0;
+}
+
 /**
  * @brief Handles IOCTL commands from user space.
  *
@@ -97,13 +638,19 @@ static int pdm_dimmer_get_level(struct pdm_client *client, unsigned int *level)
 static long pdm_dimmer_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
 	struct pdm_client *client = filp->private_data;
+	struct pdm_dimmer_priv *dimmer_priv;
+	struct pdm_dimmer_pattern *pattern;
+	struct pdm_dimmer_group *group;
+	struct pdm_dimmer_ramp ramp;
 	unsigned int level;
+	int enable;
 	int status = 0;
 
 	if (!client) {
 		OSA_ERROR("Invalid client\n");
 		return -EINVAL;
 	}
+	dimmer_priv = pdm_client_get_private_data(client);
 
 	switch (cmd) {
 		case PDM_DIMMER_CMD_SET_LEVEL:
@@ -131,6 +678,65 @@ static long pdm_dimmer_ioctl(struct file *filp, unsigned int cmd, unsigned long
 			}
 			break;
 		}
+		case PDM_DIMMER_RAMP:
+		{
+			if (copy_from_user(&ramp, (void __user *)arg, sizeof(ramp))) {
+				OSA_ERROR("Failed to copy data from user space\n");
+				return -EFAULT;
+			}
+			status = pdm_dimmer_ramp_start(client, &ramp);
+			break;
+		}
+		case PDM_DIMMER_RAMP_CANCEL:
+		{
+			mutex_lock(&dimmer_priv->ramp_lock);
+			pdm_dimmer_ramp_stop(client, true);
+			mutex_unlock(&dimmer_priv->ramp_lock);
+			break;
+		}
+		case PDM_DIMMER_GROUP_SET:
+		{
+			group = memdup_user((void __user *)arg, sizeof(*group));
+			if (IS_ERR(group)) {
+				OSA_ERROR("Failed to copy data from user space\n");
+				return PTR_ERR(group);
+			}
+
+			status = pdm_dimmer_group_set(group);
+			if (!status && copy_to_user((void __user *)arg, group, sizeof(*group))) {
+				OSA_ERROR("Failed to copy data to user space\n");
+				status = -EFAULT;
+			}
+			kfree(group);
+			break;
+		}
+		case PDM_DIMMER_PATTERN_SET:
+		{
+			pattern = memdup_user((void __user *)arg, sizeof(*pattern));
+			if (IS_ERR(pattern)) {
+				OSA_ERROR("Failed to copy data from user space\n");
+				return PTR_ERR(pattern);
+			}
+			status = pdm_dimmer_pattern_start(client, pattern);
+			kfree(pattern);
+			break;
+		}
+		case PDM_DIMMER_PATTERN_CLEAR:
+		{
+			mutex_lock(&dimmer_priv->ramp_lock);
+			pdm_dimmer_pattern_stop(client, true);
+			mutex_unlock(&dimmer_priv->ramp_lock);
+			break;
+		}
+		case PDM_DIMMER_EVENT_ENABLE:
+		{
+			if (copy_from_user(&enable, (void __user *)arg, sizeof(enable))) {
+				OSA_ERROR("Failed to copy data from user space\n");
+				return -EFAULT;
+			}
+			pdm_client_event_enable(client, !!enable);
+			break;
+		}
 		default:
 		{
 			OSA_ERROR("Unknown ioctl command\n");
@@ -158,12 +764,17 @@ static long pdm_dimmer_ioctl(struct file *filp, unsigned int cmd, unsigned long
  */
 static ssize_t pdm_dimmer_read(struct file *filp, char __user *buf, size_t count, loff_t *ppos)
 {
+	struct pdm_client *client = filp->private_data;
 	const char help_info[] =
 		"Available commands:\n"
-		" > 1 <0-255>	- Set DIMMER level\n"
+		" > 1 <level>	- Set DIMMER level\n"
 		" > 2		- Get current DIMMER level\n";
 	size_t len = strlen(help_info);
 
+	if (pdm_client_event_enabled(client)) {
+		return pdm_client_event_read(client, filp, buf, count);
+	}
+
 	if (*ppos >= len)
 		return 0;
 
@@ -256,7 +867,10 @@ static ssize_t pdm_dimmer_write(struct file *filp, const char __user *buf, size_
  */
 static int pdm_dimmer_device_probe(struct pdm_device *pdmdev)
 {
+	struct pdm_dimmer_priv *dimmer_priv;
 	struct pdm_client *client;
+	struct device_node *np;
+	u32 group[2];
 	int status;
 
 	client = devm_pdm_client_alloc(pdmdev, sizeof(struct pdm_dimmer_priv));
@@ -265,6 +879,18 @@ static int pdm_dimmer_device_probe(struct pdm_device *pdmdev)
 		return PTR_ERR(client);
 	}
 
+	dimmer_priv = pdm_client_get_private_data(client);
+	dimmer_priv->client = client;
+	mutex_init(&dimmer_priv->lock);
+	pdm_dimmer_ramp_init(dimmer_priv);
+
+	/* dimmer-group = <group position>, e.g. the channels of one RGBW fixture */
+	np = pdm_client_get_of_node(client);
+	if (np && !of_property_read_u32_array(np, "dimmer-group", group, ARRAY_SIZE(group))) {
+		dimmer_priv->group = group[0];
+		dimmer_priv->group_pos = group[1];
+	}
+
 	status = devm_pdm_client_register(dimmer_adapter, client);
 	if (status) {
 		OSA_ERROR("DIMMER Adapter Add Device Failed, status=%d\n", status);
@@ -293,7 +919,14 @@ static int pdm_dimmer_device_probe(struct pdm_device *pdmdev)
  */
 static void pdm_dimmer_device_remove(struct pdm_device *pdmdev)
 {
+	struct pdm_dimmer_priv *dimmer_priv;
+
 	if (pdmdev && pdmdev->client) {
+		dimmer_priv = pdm_client_get_private_data(pdmdev->client);
+		mutex_lock(&dimmer_priv->ramp_lock);
+		pdm_dimmer_effects_stop(pdmdev->client, false);
+		mutex_unlock(&dimmer_priv->ramp_lock);
+		pdm_client_event_enable(pdmdev->client, false);
 		pdm_client_cleanup(pdmdev->client);
 	}
 }
@@ -9,7 +9,12 @@
   DIMMER driver, used to manage and operate PDM DIMMER devices.
  */
 
+#include <linux/hrtimer.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+
 #include "pdm.h"
+#include "pdm_dimmer_ioctl.h"
 
 /**
  * @def PDM_DIMMER_NAME
@@ -24,7 +29,53 @@ enum pdm_dimmer_command {
 	PDM_DIMMER_CMD_INVALID		= 0xFF
 };
 
-#define PDM_DIMMER_MAX_LEVEL_VALUE	(0xFF)
+#define PDM_DIMMER_MAX_LEVEL_VALUE	(0xFF)		/* Default full scale of level-map duty cycles */
+#define PDM_DIMMER_LEVEL_COUNT_MAX	(4096)		/* Most levels a dimmer may have */
+
+#define PDM_DIMMER_RAMP_TICK_US		(10000)		/* Default ramp step interval */
+#define PDM_DIMMER_RAMP_TICK_MIN_US	(1000)		/* Shortest accepted step interval */
+#define PDM_DIMMER_RAMP_DURATION_MAX_MS	(3600000)	/* Longest accepted ramp */
+
+/**
+ * @struct pdm_dimmer_ramp_state
+ * @brief In-kernel fade from one level to another
+ *
+ * The hrtimer paces the steps, the levels are applied from a work item since the backends
+ * may sleep. Each step is computed from the elapsed time, a late step does not stretch the ramp.
+ */
+struct pdm_dimmer_ramp_state {
+	struct hrtimer timer;			/**< Step tick */
+	struct work_struct work;		/**< Applies the level of the current step */
+	ktime_t start;				/**< Ramp start time */
+	ktime_t tick;				/**< Step interval */
+	u64 duration_ns;			/**< Ramp length */
+	unsigned int from;			/**< Level at the start */
+	unsigned int to;			/**< Target level */
+	unsigned int curve;			/**< enum pdm_dimmer_ramp_curve */
+	unsigned int level;			/**< Level last applied */
+	bool active;				/**< Ramp running */
+};
+
+/**
+ * @struct pdm_dimmer_pattern_state
+ * @brief Software pattern player
+ *
+ * The timer fires at step boundaries only, smooth steps add fade ticks in between.
+ * Expiries are absolute, so the pattern does not drift over many repeats.
+ */
+struct pdm_dimmer_pattern_state {
+	struct hrtimer timer;			/**< Next step or fade tick */
+	struct work_struct work;		/**< Applies the level due now */
+	struct pdm_dimmer_pattern pattern;	/**< Steps being played */
+	ktime_t tick;				/**< Fade tick of smooth patterns */
+	ktime_t step_start;			/**< Start of the current step */
+	ktime_t step_end;			/**< End of the current step */
+	unsigned int step;			/**< Current step */
+	unsigned int cycle;			/**< Completed repeats */
+	unsigned int level;			/**< Level last applied */
+	bool hw;				/**< Played by the backend */
+	bool active;				/**< Pattern running */
+};
 
 /**
  * @struct pdm_dimmer_priv
@@ -34,10 +85,24 @@ enum pdm_dimmer_command {
  * operation functions.
  */
 struct pdm_dimmer_priv {
+	struct pdm_client *client;
+	struct mutex lock;			/**< Serializes level changes */
+	struct mutex ramp_lock;			/**< Serializes ramp and pattern start and stop */
+	struct pdm_dimmer_ramp_state ramp;	/**< Fade engine */
+	struct pdm_dimmer_pattern_state pattern;	/**< Pattern player */
+	unsigned int group;			/**< DT group, PDM_DIMMER_GROUP_NONE if not a member */
+	unsigned int group_pos;			/**< Member position inside the DT group */
 	unsigned int max_level;
-	unsigned int *level_map;
+	u16 *level_map;				/**< Duty cycle of each level, in backend units */
+	void *hw_priv;				/**< Backend private data */
 	int (*set_level)(struct pdm_client *client, unsigned int level);
 	int (*get_level)(struct pdm_client *client, unsigned int *level);
+	/* Optional: split level change for group updates, all members are prepared before any commit */
+	int (*prepare_level)(struct pdm_client *client, unsigned int level);
+	int (*commit_level)(struct pdm_client *client);
+	/* Optional: hardware pattern playback, -EOPNOTSUPP selects the software player */
+	int (*pattern_set)(struct pdm_client *client, const struct pdm_dimmer_pattern *pattern);
+	int (*pattern_clear)(struct pdm_client *client);
 };
 
 /**
@@ -1,25 +1,323 @@
 #include <linux/pwm.h>
+#include <linux/math64.h>
+#include <linux/int_sqrt.h>
+#include <linux/sort.h>
 
 #include "pdm.h"
 #include "pdm_dimmer_priv.h"
 
+#define PDM_DIMMER_PWM_DUTY_SCALE	(0xFFFF)	/* 16-bit duty resolution of generated curves */
+#define PDM_DIMMER_PWM_LEVELS		(256)		/* Default number of generated levels */
+#define PDM_DIMMER_PWM_GAMMA		(2200)		/* Default gamma exponent, in 1/1000 */
 
-static int pdm_dimmer_pwm_set_level(struct pdm_client *client, unsigned int level)
+/**
+ * @brief Brightness curves that can be generated instead of a DT level-map.
+ */
+enum pdm_dimmer_pwm_curve {
+	PDM_DIMMER_PWM_CURVE_LINEAR,
+	PDM_DIMMER_PWM_CURVE_GAMMA,
+	PDM_DIMMER_PWM_CURVE_CIE1931,
+};
+
+static const char * const pdm_dimmer_pwm_curve_names[] = {
+	[PDM_DIMMER_PWM_CURVE_LINEAR]	= "linear",
+	[PDM_DIMMER_PWM_CURVE_GAMMA]	= "gamma",
+	[PDM_DIMMER_PWM_CURVE_CIE1931]	= "cie1931",
+};
+
+/**
+ * @brief Entry of the duty cycle to level index.
+ */
+struct pdm_dimmer_pwm_index {
+	u16 duty;
+	u16 level;
+};
+
+/**
+ * @brief PWM dimmer private data.
+ */
+struct pdm_dimmer_pwm_data {
+	u64 period;					/* Period from the PWM reference, fetched once */
+	unsigned int level;				/* Level last committed to the PWM */
+	bool committed;					/* level matches the hardware */
+	struct pwm_state pending;			/* State computed by prepare_level */
+	unsigned int pending_level;			/* Level of the pending state */
+	bool pending_valid;				/* A prepared state awaits commit */
+	unsigned int duty_scale;			/* Full scale of the level_map duty cycles */
+	struct pdm_dimmer_pwm_index *index;		/* Duty cycles in ascending order, without duplicates */
+	unsigned int index_count;			/* Entries in index */
+};
+
+/**
+ * @brief Returns log2 of a Q16 fraction in (0, 1] as a Q16 value.
+ */
+static s64 pdm_dimmer_pwm_log2(u64 x)
 {
-	struct pdm_dimmer_priv *dimmer_priv;
-	struct pwm_device *pwmdev;
-	struct pwm_state pwmstate;
-	struct pwm_args pwmargs;
-	unsigned int duty_cycle;
+	int msb = fls64(x) - 1;
+	s64 result = (s64)(msb - 16) << 16;
+	u64 y;
+	int bit;
+
+	/* Normalize to [1, 2) in Q30, each squaring yields one fraction bit */
+	y = (msb > 30) ? x >> (msb - 30) : x << (30 - msb);
+	for (bit = 15; bit >= 0; bit--) {
+		y = (y * y) >> 30;
+		if (y >= (2ULL << 30)) {
+			y >>= 1;
+			result += 1 << bit;
+		}
+	}
+
+	return result;
+}
+
+/**
+ * @brief Returns 2^x as a Q16 value for a Q16 exponent x <= 0.
+ */
+static u64 pdm_dimmer_pwm_exp2(s64 x)
+{
+	u64 a = -x;
+	unsigned int ipart = a >> 16;
+	unsigned int frac = (1 << 16) - (a & 0xFFFF);
+	u64 result = 1ULL << 30;
+	u64 root = 2ULL << 30;
+	int k;
+
+	if (ipart >= 32) {
+		return 0;
+	}
+
+	/* 2^-a = 2^-(ipart + 1) * 2^frac, 2^frac is the product of 2^(2^-k) over its set bits */
+	if (frac == (1 << 16)) {
+		result = 2ULL << 30;
+	} else {
+		for (k = 1; k <= 16; k++) {
+			root = int_sqrt64(root << 30);
+			if (frac & (1 << (16 - k))) {
+				result = (result * root) >> 30;
+			}
+		}
+	}
+
+	return result >> (ipart + 1 + 14);
+}
+
+/**
+ * @brief Returns the duty cycle of @level on a generated curve, in 1/PDM_DIMMER_PWM_DUTY_SCALE.
+ */
+static unsigned int pdm_dimmer_pwm_curve_duty(unsigned int curve, unsigned int gamma,
+					      unsigned int level, unsigned int max_level)
+{
+	u64 x, y, t;
+
+	if (!level) {
+		return 0;
+	}
+
+	switch (curve) {
+		case PDM_DIMMER_PWM_CURVE_GAMMA:
+			x = div_u64((u64)level << 16, max_level);
+			y = pdm_dimmer_pwm_exp2(div_s64(pdm_dimmer_pwm_log2(x) * gamma, 1000));
+			break;
+		case PDM_DIMMER_PWM_CURVE_CIE1931:
+			/* Lightness L* = 100 * level / max_level, luminance Y from the CIE 1931 formula */
+			x = div_u64((u64)level * 100 << 16, max_level);
+			if (x <= (8 << 16)) {
+				y = div_u64(x * 10, 9033);
+			} else {
+				t = div_u64(x + (16 << 16), 116);
+				y = (((t * t) >> 16) * t) >> 16;
+			}
+			break;
+		case PDM_DIMMER_PWM_CURVE_LINEAR:
+		default:
+			y = div_u64((u64)level << 16, max_level);
+			break;
+	}
+
+	y = (y * PDM_DIMMER_PWM_DUTY_SCALE + (1 << 15)) >> 16;
+
+	/* Every level above 0 must light the output */
+	return clamp_t(u64, y, 1, PDM_DIMMER_PWM_DUTY_SCALE);
+}
+
+/**
+ * @brief Fills the level map from a DT level-map array or from a generated curve.
+ *
+ * level-map entries are duty cycles relative to level-map-max, 255 by default. Without a
+ * level-map, brightness-levels levels are generated with 16-bit duty resolution along
+ * brightness-curve ("linear", "gamma" with brightness-gamma in 1/1000, or "cie1931").
+ */
+static int pdm_dimmer_pwm_load_level_map(struct pdm_dimmer_priv *dimmer_priv, struct pdm_dimmer_pwm_data *pwm_data,
+					 struct device_node *np)
+{
+	unsigned int level_count;
+	int map_count;
+	unsigned int curve = PDM_DIMMER_PWM_CURVE_CIE1931;
+	unsigned int gamma = PDM_DIMMER_PWM_GAMMA;
+	const char *name;
+	u32 *values;
+	unsigned int i;
 	int status;
 
-	if (!client || !client->pdmdev) {
-		OSA_ERROR("Invalid client\n");
+	map_count = of_property_count_elems_of_size(np, "level-map", sizeof(u32));
+	if (map_count > PDM_DIMMER_LEVEL_COUNT_MAX) {
+		OSA_ERROR("level-map has more than %u levels\n", PDM_DIMMER_LEVEL_COUNT_MAX);
 		return -EINVAL;
 	}
 
-	pwmdev = client->hardware.pwm.pwmdev;
-	if (!pwmdev) {
+	if (map_count > 0) {
+		level_count = map_count;
+		pwm_data->duty_scale = PDM_DIMMER_MAX_LEVEL_VALUE;
+		of_property_read_u32(np, "level-map-max", &pwm_data->duty_scale);
+		if (!pwm_data->duty_scale || pwm_data->duty_scale > PDM_DIMMER_PWM_DUTY_SCALE) {
+			OSA_ERROR("Invalid level-map-max: %u\n", pwm_data->duty_scale);
+			return -EINVAL;
+		}
+
+		values = kcalloc(level_count, sizeof(*values), GFP_KERNEL);
+		dimmer_priv->level_map = kcalloc(level_count, sizeof(*dimmer_priv->level_map), GFP_KERNEL);
+		if (!values || !dimmer_priv->level_map) {
+			OSA_ERROR("Failed to allocate memory for level map\n");
+			status = -ENOMEM;
+			goto err_free;
+		}
+
+		status = of_property_read_u32_array(np, "level-map", values, level_count);
+		if (status) {
+			OSA_ERROR("Failed to get levels\n");
+			goto err_free;
+		}
+
+		for (i = 0; i < level_count; i++) {
+			if (values[i] > pwm_data->duty_scale) {
+				OSA_ERROR("Invalid real level: %u\n", values[i]);
+				status = -EINVAL;
+				goto err_free;
+			}
+			dimmer_priv->level_map[i] = values[i];
+		}
+		kfree(values);
+
+		dimmer_priv->max_level = level_count - 1;
+		return 0;
+	}
+
+	level_count = PDM_DIMMER_PWM_LEVELS;
+	of_property_read_u32(np, "brightness-levels", &level_count);
+	if (level_count < 2 || level_count > PDM_DIMMER_LEVEL_COUNT_MAX) {
+		OSA_ERROR("Invalid brightness-levels: %u\n", level_count);
+		return -EINVAL;
+	}
+
+	if (!of_property_read_string(np, "brightness-curve", &name)) {
+		status = match_string(pdm_dimmer_pwm_curve_names, ARRAY_SIZE(pdm_dimmer_pwm_curve_names), name);
+		if (status < 0) {
+			OSA_ERROR("Unknown brightness-curve: %s\n", name);
+			return status;
+		}
+		curve = status;
+	}
+	of_property_read_u32(np, "brightness-gamma", &gamma);
+
+	dimmer_priv->level_map = kcalloc(level_count, sizeof(*dimmer_priv->level_map), GFP_KERNEL);
+	if (!dimmer_priv->level_map) {
+		OSA_ERROR("Failed to allocate memory for level map\n");
+		return -ENOMEM;
+	}
+
+	dimmer_priv->max_level = level_count - 1;
+	pwm_data->duty_scale = PDM_DIMMER_PWM_DUTY_SCALE;
+	for (i = 0; i < level_count; i++) {
+		dimmer_priv->level_map[i] = pdm_dimmer_pwm_curve_duty(curve, gamma, i, dimmer_priv->max_level);
+	}
+
+	OSA_DEBUG("Generated %u level %s curve\n", level_count, pdm_dimmer_pwm_curve_names[curve]);
+	return 0;
+
+err_free:
+	kfree(values);
+	kfree(dimmer_priv->level_map);
+	dimmer_priv->level_map = NULL;
+	return status;
+}
+
+static int pdm_dimmer_pwm_index_cmp(const void *a, const void *b)
+{
+	const struct pdm_dimmer_pwm_index *ia = a;
+	const struct pdm_dimmer_pwm_index *ib = b;
+
+	if (ia->duty != ib->duty) {
+		return ia->duty < ib->duty ? -1 : 1;
+	}
+	return ia->level < ib->level ? -1 : (ia->level > ib->level);
+}
+
+/**
+ * @brief Builds the duty cycle to level index, the lowest level wins for shared duty cycles.
+ */
+static int pdm_dimmer_pwm_build_index(struct pdm_client *client, struct pdm_dimmer_priv *dimmer_priv,
+				      struct pdm_dimmer_pwm_data *pwm_data)
+{
+	unsigned int count = dimmer_priv->max_level + 1;
+	unsigned int i, n;
+
+	pwm_data->index = devm_kcalloc(&client->pdmdev->dev, count, sizeof(*pwm_data->index), GFP_KERNEL);
+	if (!pwm_data->index) {
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < count; i++) {
+		pwm_data->index[i].duty = dimmer_priv->level_map[i];
+		pwm_data->index[i].level = i;
+	}
+	sort(pwm_data->index, count, sizeof(*pwm_data->index), pdm_dimmer_pwm_index_cmp, NULL);
+
+	for (i = 1, n = 1; i < count; i++) {
+		if (pwm_data->index[i].duty != pwm_data->index[n - 1].duty) {
+			pwm_data->index[n++] = pwm_data->index[i];
+		}
+	}
+	pwm_data->index_count = n;
+
+	return 0;
+}
+
+/**
+ * @brief Returns the level whose duty cycle is nearest to @duty.
+ */
+static unsigned int pdm_dimmer_pwm_lookup(struct pdm_dimmer_pwm_data *pwm_data, unsigned int duty)
+{
+	unsigned int lo = 0, hi = pwm_data->index_count, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (pwm_data->index[mid].duty < duty) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (lo == pwm_data->index_count
+		|| (lo > 0 && duty - pwm_data->index[lo - 1].duty < pwm_data->index[lo].duty - duty)) {
+		lo--;
+	}
+
+	return pwm_data->index[lo].level;
+}
+
+/**
+ * @brief Computes the PWM state of @level without touching the hardware.
+ */
+static int pdm_dimmer_pwm_prepare_level(struct pdm_client *client, unsigned int level)
+{
+	struct pdm_dimmer_priv *dimmer_priv;
+	struct pdm_dimmer_pwm_data *pwm_data;
+	unsigned int duty_cycle;
+
+	if (!client || !client->pdmdev || !client->hardware.pwm.pwmdev) {
+		OSA_ERROR("Invalid client\n");
 		return -EINVAL;
 	}
 
@@ -34,43 +332,80 @@ static int pdm_dimmer_pwm_set_level(struct pdm_client *client, unsigned int leve
 		return -EINVAL;
 	}
 
-	OSA_DEBUG("PWM PDM Dimmer: Set %s level to %u\n", dev_name(&client->dev), level);
+	pwm_data = dimmer_priv->hw_priv;
+	memset(&pwm_data->pending, 0, sizeof(pwm_data->pending));
+	if (level) {
+		duty_cycle = dimmer_priv->level_map[level];
+		pwm_data->pending.period = pwm_data->period;
+		pwm_data->pending.enabled = true;
+		pwm_set_relative_duty_cycle(&pwm_data->pending, duty_cycle, pwm_data->duty_scale);
+	}
+	pwm_data->pending_level = level;
+	pwm_data->pending_valid = true;
 
-	if (!level) {
-		pwm_disable(pwmdev);
+	return 0;
+}
+
+/**
+ * @brief Applies the state computed by the last prepare_level, skipped if already committed.
+ */
+static int pdm_dimmer_pwm_commit_level(struct pdm_client *client)
+{
+	struct pdm_dimmer_priv *dimmer_priv = pdm_client_get_private_data(client);
+	struct pdm_dimmer_pwm_data *pwm_data = dimmer_priv->hw_priv;
+	struct pwm_device *pwmdev = client->hardware.pwm.pwmdev;
+	int status;
+
+	if (!pwm_data->pending_valid) {
+		return -EINVAL;
+	}
+	pwm_data->pending_valid = false;
+
+	if (pwm_data->committed && pwm_data->level == pwm_data->pending_level) {
 		return 0;
 	}
 
-	duty_cycle = dimmer_priv->level_map[level];
-	if (duty_cycle > PDM_DIMMER_MAX_LEVEL_VALUE) {
-		OSA_ERROR("Invalid real level: %u\n", duty_cycle);
-		return -EINVAL;
+	OSA_DEBUG("PWM PDM Dimmer: Set %s level to %u\n", dev_name(&client->dev), pwm_data->pending_level);
+
+	if (!pwm_data->pending.enabled) {
+		pwm_disable(pwmdev);
+	} else {
+		status = pwm_apply_might_sleep(pwmdev, &pwm_data->pending);
+		if (status) {
+			OSA_ERROR("pwm_apply_might_sleep failed: %d\n", status);
+			/* The hardware state is unknown now, the next set must not be skipped */
+			pwm_data->committed = false;
+			return status;
+		}
 	}
 
-	memset(&pwmargs, 0, sizeof(pwmargs));
-	pwm_get_args(pwmdev, &pwmargs);
+	pwm_data->level = pwm_data->pending_level;
+	pwm_data->committed = true;
+	return 0;
+}
 
-	memset(&pwmstate, 0, sizeof(pwmstate));
-	pwmstate.period = pwmargs.period;
-	pwmstate.enabled = true;
-	pwm_set_relative_duty_cycle(&pwmstate, duty_cycle, PDM_DIMMER_MAX_LEVEL_VALUE);
-	status = pwm_apply_might_sleep(pwmdev, &pwmstate);
+static int pdm_dimmer_pwm_set_level(struct pdm_client *client, unsigned int level)
+{
+	int status;
+
+	status = pdm_dimmer_pwm_prepare_level(client, level);
 	if (status) {
-		OSA_ERROR("pwm_apply_might_sleep failed: %d\n", status);
 		return status;
 	}
 
-	return 0;
+	return pdm_dimmer_pwm_commit_level(client);
 }
 
+/**
+ * @brief Returns the committed level, the PWM is only queried while none is known.
+ */
 static int pdm_dimmer_pwm_get_level(struct pdm_client *client, unsigned int *level)
 {
 	struct pdm_dimmer_priv *dimmer_priv;
+	struct pdm_dimmer_pwm_data *pwm_data;
 	struct pwm_device *pwmdev;
 	struct pwm_state pwmstate;
 	unsigned int duty_cycle;
-	int index;
-	int status = -ENOENT;
 
 	if (!client || !client->pdmdev) {
 		OSA_ERROR("Invalid client\n");
@@ -88,29 +423,22 @@ static int pdm_dimmer_pwm_get_level(struct pdm_client *client, unsigned int *lev
 		return -ENOMEM;
 	}
 
+	pwm_data = dimmer_priv->hw_priv;
+	if (pwm_data->committed) {
+		*level = pwm_data->level;
+		return 0;
+	}
+
 	memset(&pwmstate, 0, sizeof(pwmstate));
 	pwm_get_state(pwmdev, &pwmstate);
 
 	*level = 0;
-	if (pwmstate.enabled) {
-		duty_cycle = pwm_get_relative_duty_cycle(&pwmstate, PDM_DIMMER_MAX_LEVEL_VALUE);
-		for (index = 0; index <= dimmer_priv->max_level; index++)
-		{
-			if (duty_cycle == dimmer_priv->level_map[index]) {
-				*level = index;
-				status = 0;
-				break;
-			}
-		}
-	} else {
-		*level = 0;
-		status = 0;
+	if (pwmstate.enabled && pwmstate.period) {
+		duty_cycle = pwm_get_relative_duty_cycle(&pwmstate, pwm_data->duty_scale);
+		*level = pdm_dimmer_pwm_lookup(pwm_data, duty_cycle);
 	}
 
-	if (status) {
-		OSA_ERROR("PWM PDM Dimmer: Get level failed\n");
-		return status;
-	}
+	/* The nearest level need not match the hardware duty, only commit_level fills the cache */
 
 	OSA_INFO("PWM PDM Dimmer: Get %s level: %u\n", dev_name(&client->dev), *level);
 	return 0;
@@ -127,12 +455,12 @@ static int pdm_dimmer_pwm_get_level(struct pdm_client *client, unsigned int *lev
 static int pdm_dimmer_pwm_setup(struct pdm_client *client)
 {
 	struct pdm_dimmer_priv *dimmer_priv;
+	struct pdm_dimmer_pwm_data *pwm_data;
 	struct pwm_device *pwmdev;
 	struct pwm_state pwmstate;
+	struct pwm_args pwmargs;
 	struct device_node *np;
 	unsigned int default_level;
-	unsigned int level_count;
-	unsigned int *level_map;
 	int status;
 
 	if (!client) {
@@ -146,8 +474,17 @@ static int pdm_dimmer_pwm_setup(struct pdm_client *client)
 		return -ENOMEM;
 	}
 
+	pwm_data = devm_kzalloc(&client->pdmdev->dev, sizeof(*pwm_data), GFP_KERNEL);
+	if (!pwm_data) {
+		OSA_ERROR("Failed to allocate PWM dimmer data\n");
+		return -ENOMEM;
+	}
+	dimmer_priv->hw_priv = pwm_data;
+
 	dimmer_priv->set_level = pdm_dimmer_pwm_set_level;
 	dimmer_priv->get_level = pdm_dimmer_pwm_get_level;
+	dimmer_priv->prepare_level = pdm_dimmer_pwm_prepare_level;
+	dimmer_priv->commit_level = pdm_dimmer_pwm_commit_level;
 
 	np = pdm_client_get_of_node(client);
 	if (!np) {
@@ -155,33 +492,25 @@ static int pdm_dimmer_pwm_setup(struct pdm_client *client)
 		return -EINVAL;
 	}
 
+	status = pdm_dimmer_pwm_load_level_map(dimmer_priv, pwm_data, np);
+	if (status) {
+		OSA_ERROR("Failed to get max level\n");
+		return status;
+	}
+
 	status = of_property_read_u32(np, "default-level", &default_level);
 	if (status) {
 		OSA_WARN("No default-state property found, using defaults as off\n");
 		default_level = 0;
-	} else if (default_level > PDM_DIMMER_MAX_LEVEL_VALUE) {
-		OSA_WARN("Invalid default-level (0~255): %u\n", default_level);
+	} else if (default_level > dimmer_priv->max_level) {
+		OSA_WARN("Invalid default-level (0~%u): %u\n", dimmer_priv->max_level, default_level);
 		OSA_WARN("Set default-level to 0\n");
 		default_level = 0;
 	}
 
-	level_count = of_property_count_elems_of_size(np, "level-map", sizeof(u32));
-	if (level_count == 0) {
-		OSA_ERROR("Failed to get max level\n");
-		return -EINVAL;
-	}
-	dimmer_priv->max_level = level_count - 1;
-
-	level_map = kmalloc(level_count * sizeof(u32), GFP_KERNEL);
-	if (!level_map) {
-		OSA_ERROR("Failed to allocate memory for level map\n");
-		return -ENOMEM;
-	}
-	dimmer_priv->level_map = level_map;
-
-	status = of_property_read_u32_array(np, "level-map", level_map, level_count);
+	status = pdm_dimmer_pwm_build_index(client, dimmer_priv, pwm_data);
 	if (status) {
-		OSA_ERROR("Failed to get levels\n");
+		OSA_ERROR("Failed to allocate level index\n");
 		goto err_level_map_free;
 	}
 
@@ -195,6 +524,10 @@ static int pdm_dimmer_pwm_setup(struct pdm_client *client)
 
 	pwm_init_state(pwmdev, &pwmstate);
 
+	memset(&pwmargs, 0, sizeof(pwmargs));
+	pwm_get_args(pwmdev, &pwmargs);
+	pwm_data->period = pwmargs.period;
+
 	status = pdm_dimmer_pwm_set_level(client, default_level);
 	if (status) {
 		OSA_WARN("Failed to set default level: %d\n", status);
@@ -204,7 +537,7 @@ static int pdm_dimmer_pwm_setup(struct pdm_client *client)
 	return 0;
 
 err_level_map_free:
-	kfree(level_map);
+	kfree(dimmer_priv->level_map);
 	dimmer_priv->level_map = NULL;
 	return status;
 }
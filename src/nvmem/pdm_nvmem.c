@@ -1,3 +1,11 @@
+#include <linux/bitmap.h>
+#include <linux/debugfs.h>
+#include <linux/mm.h>
+#include <linux/nvmem-provider.h>
+#include <linux/seq_file.h>
+#include <linux/uio.h>
+#include <linux/vmalloc.h>
+
 #include "pdm.h"
 #include "pdm_adapter_priv.h"
 #include "pdm_nvmem_ioctl.h"
@@ -6,10 +14,27 @@
 static struct pdm_adapter *nvmem_adapter = NULL;
 
 /**
- * @brief Sets the state of a specified PDM NVMEM device.
+ * @brief Per-open state of an NVMEM client file, stored in filp->private_data.
+ */
+struct pdm_nvmem_file {
+	struct pdm_client *client;
+	loff_t last_end;		/* End of the last read, reads starting here are sequential */
+};
+
+static struct pdm_client *pdm_nvmem_file_client(struct file *filp)
+{
+	struct pdm_nvmem_file *nvmem_file = filp->private_data;
+
+	return nvmem_file->client;
+}
+
+/**
+ * @brief Reads a block of a specified PDM NVMEM device.
  *
  * @param client Pointer to the PDM client structure.
- * @param state State value (0 or 1).
+ * @param offset Device offset.
+ * @param val Destination buffer.
+ * @param bytes Number of bytes to read.
  * @return Returns 0 on success; negative error code on failure.
  */
 static int pdm_nvmem_read_reg(struct pdm_client *client, unsigned int offset, void *val, size_t bytes)
@@ -43,10 +68,12 @@ static int pdm_nvmem_read_reg(struct pdm_client *client, unsigned int offset, vo
 }
 
 /**
- * @brief Gets the current state of a specified PDM NVMEM device.
+ * @brief Writes a block of a specified PDM NVMEM device.
  *
  * @param client Pointer to the PDM client structure.
- * @param state Pointer to store the current state.
+ * @param offset Device offset.
+ * @param val Source buffer.
+ * @param bytes Number of bytes to write.
  * @return Returns 0 on success; negative error code on failure.
  */
 static int pdm_nvmem_write_reg(struct pdm_client *client, unsigned int offset, void *val, size_t bytes)
@@ -79,6 +106,404 @@ static int pdm_nvmem_write_reg(struct pdm_client *client, unsigned int offset, v
 	return 0;
 }
 
+/**
+ * @brief Programs every dirty write-back page to the device.
+ *
+ * Must be called with nvmem_priv->lock held. Pages that fail stay dirty and are retried
+ * on the next flush.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @return Returns 0 on success; the first error code on failure.
+ */
+int pdm_nvmem_wb_flush(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	unsigned int pages;
+	unsigned int page;
+	int status = 0;
+	int ret;
+
+	if (!nvmem_priv->wb_buf) {
+		return 0;
+	}
+
+	pages = nvmem_priv->size / nvmem_priv->page_size;
+	if (bitmap_empty(nvmem_priv->wb_dirty, pages)) {
+		return 0;
+	}
+
+	nvmem_priv->stats.flushes++;
+	for_each_set_bit(page, nvmem_priv->wb_dirty, pages) {
+		ret = pdm_nvmem_write_reg(client, page * nvmem_priv->page_size,
+					  nvmem_priv->wb_buf + page * nvmem_priv->page_size, nvmem_priv->page_size);
+		if (ret) {
+			nvmem_priv->stats.flush_errors++;
+			if (!status) {
+				status = ret;
+			}
+			continue;
+		}
+		clear_bit(page, nvmem_priv->wb_dirty);
+		nvmem_priv->stats.pages_flushed++;
+	}
+
+	return status;
+}
+
+/**
+ * @brief Delayed flush of the write-back cache.
+ */
+static void pdm_nvmem_flush_work_func(struct work_struct *work)
+{
+	struct pdm_nvmem_priv *nvmem_priv = container_of(to_delayed_work(work), struct pdm_nvmem_priv, flush_work);
+	int status;
+
+	mutex_lock(&nvmem_priv->lock);
+	status = pdm_nvmem_wb_flush(nvmem_priv->client);
+	mutex_unlock(&nvmem_priv->lock);
+
+	if (status) {
+		OSA_WARN("Delayed NVMEM flush failed, status: %d\n", status);
+	}
+}
+
+/**
+ * @brief Reads a block, serving cached write-back pages without touching the device.
+ *
+ * Once the shadow image is loaded it already holds the latest data and is used instead,
+ * otherwise reads that fall inside the read-ahead window are served from it.
+ * Must be called with nvmem_priv->lock held.
+ */
+int pdm_nvmem_xfer_read(struct pdm_client *client, unsigned int offset, void *val, size_t bytes)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	unsigned int page, start, end;
+	bool cached;
+	int status;
+
+	if (nvmem_priv->shadow_loaded) {
+		memcpy(val, nvmem_priv->shadow + offset, bytes);
+		return 0;
+	}
+
+	if (nvmem_priv->ra_valid && offset >= nvmem_priv->ra_start
+		&& offset + bytes <= nvmem_priv->ra_start + nvmem_priv->ra_len) {
+		memcpy(val, nvmem_priv->ra_buf + (offset - nvmem_priv->ra_start), bytes);
+		nvmem_priv->stats.ra_hits++;
+		return 0;
+	}
+
+	if (!nvmem_priv->wb_buf) {
+		return pdm_nvmem_read_reg(client, offset, val, bytes);
+	}
+
+	/* Cached pages are copied, only the runs of uncached pages go to the device */
+	for (start = offset; start < offset + bytes; start = end) {
+		page = start / nvmem_priv->page_size;
+		cached = test_bit(page, nvmem_priv->wb_valid);
+		do {
+			end = min_t(unsigned int, offset + bytes, (++page) * nvmem_priv->page_size);
+		} while (end < offset + bytes && test_bit(page, nvmem_priv->wb_valid) == cached);
+
+		if (cached) {
+			memcpy(val + (start - offset), nvmem_priv->wb_buf + start, end - start);
+			continue;
+		}
+
+		status = pdm_nvmem_read_reg(client, start, val + (start - offset), end - start);
+		if (status) {
+			return status;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Copies written data into the overlapping part of the read-ahead window.
+ */
+static void pdm_nvmem_ra_update(struct pdm_nvmem_priv *nvmem_priv, unsigned int offset, const void *val, size_t bytes)
+{
+	unsigned int start, end;
+
+	/* A prefetch in flight may already hold the old bytes */
+	nvmem_priv->ra_gen++;
+	if (!nvmem_priv->ra_valid) {
+		return;
+	}
+
+	start = max_t(unsigned int, offset, nvmem_priv->ra_start);
+	end = min_t(unsigned int, offset + bytes, nvmem_priv->ra_start + nvmem_priv->ra_len);
+	if (start < end) {
+		memcpy(nvmem_priv->ra_buf + (start - nvmem_priv->ra_start), val + (start - offset), end - start);
+	}
+}
+
+/**
+ * @brief Writes a block, through the write-back cache if one is configured.
+ *
+ * Partially written pages are loaded from the device first so that whole pages can be
+ * programmed on flush. The shadow image and the read-ahead window are updated on success.
+ * Must be called with nvmem_priv->lock held.
+ */
+int pdm_nvmem_xfer_write(struct pdm_client *client, unsigned int offset, const void *val, size_t bytes)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	unsigned int page_size = nvmem_priv->page_size;
+	unsigned int page, page_offset, len;
+	size_t done = 0;
+	int status;
+
+	if (!nvmem_priv->wb_buf) {
+		status = pdm_nvmem_write_reg(client, offset, (void *)val, bytes);
+		if (!status && nvmem_priv->shadow_loaded) {
+			memcpy(nvmem_priv->shadow + offset, val, bytes);
+		}
+		if (!status) {
+			pdm_nvmem_ra_update(nvmem_priv, offset, val, bytes);
+		}
+		return status;
+	}
+
+	while (done < bytes) {
+		page = (offset + done) / page_size;
+		page_offset = (offset + done) % page_size;
+		len = min_t(size_t, page_size - page_offset, bytes - done);
+
+		if (!test_bit(page, nvmem_priv->wb_valid)) {
+			if (len < page_size) {
+				status = pdm_nvmem_read_reg(client, page * page_size, nvmem_priv->wb_buf + page * page_size,
+							    page_size);
+				if (status) {
+					return status;
+				}
+				nvmem_priv->stats.page_loads++;
+			}
+			set_bit(page, nvmem_priv->wb_valid);
+		}
+
+		memcpy(nvmem_priv->wb_buf + page * page_size + page_offset, val + done, len);
+		if (!test_and_set_bit(page, nvmem_priv->wb_dirty)) {
+			nvmem_priv->stats.pages_dirtied++;
+		}
+		nvmem_priv->stats.bytes_written += len;
+		done += len;
+	}
+
+	if (nvmem_priv->shadow_loaded) {
+		memcpy(nvmem_priv->shadow + offset, val, bytes);
+	}
+	pdm_nvmem_ra_update(nvmem_priv, offset, val, bytes);
+
+	if (nvmem_priv->flush_delay_ms) {
+		schedule_delayed_work(&nvmem_priv->flush_work, msecs_to_jiffies(nvmem_priv->flush_delay_ms));
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Allocates the shadow image if needed and fills it with the device contents.
+ *
+ * Must be called with nvmem_priv->lock held.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_nvmem_shadow_load(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	unsigned int offset;
+	size_t chunk;
+	int status;
+
+	if (!nvmem_priv->size) {
+		return -ENODEV;
+	}
+
+	if (!nvmem_priv->shadow) {
+		nvmem_priv->shadow = vmalloc_user(PAGE_ALIGN(nvmem_priv->size));
+		if (!nvmem_priv->shadow) {
+			OSA_ERROR("Failed to allocate NVMEM shadow\n");
+			return -ENOMEM;
+		}
+	}
+
+	nvmem_priv->shadow_loaded = false;
+	for (offset = 0; offset < nvmem_priv->size; offset += chunk) {
+		chunk = min_t(size_t, nvmem_priv->size - offset, PDM_NVMEM_XFER_CHUNK);
+		status = pdm_nvmem_xfer_read(client, offset, nvmem_priv->shadow + offset, chunk);
+		if (status) {
+			OSA_ERROR("Failed to load NVMEM shadow at 0x%x, status: %d\n", offset, status);
+			return status;
+		}
+	}
+	nvmem_priv->shadow_loaded = true;
+
+	return 0;
+}
+
+/**
+ * @brief Sets up the write-back cache when the DT node opts in with "write-back-delay-ms".
+ *
+ * "pagesize" only describes the part, it sets the cache page size but does not enable it.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_nvmem_wb_init(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct device_node *np = pdm_client_get_of_node(client);
+	unsigned int pages;
+
+	INIT_DELAYED_WORK(&nvmem_priv->flush_work, pdm_nvmem_flush_work_func);
+
+	if (!np) {
+		return 0;
+	}
+
+	if (of_property_read_u32(np, "pagesize", &nvmem_priv->page_size)) {
+		nvmem_priv->page_size = 0;
+	}
+
+	/* Delayed writes are lost on power cut, the cache is strictly opt-in */
+	if (of_property_read_u32(np, "write-back-delay-ms", &nvmem_priv->flush_delay_ms)) {
+		nvmem_priv->flush_delay_ms = 0;
+		return 0;
+	}
+
+	if (!nvmem_priv->page_size || !is_power_of_2(nvmem_priv->page_size) || !nvmem_priv->size
+		|| nvmem_priv->size % nvmem_priv->page_size) {
+		OSA_ERROR("Invalid pagesize %u for size %u\n", nvmem_priv->page_size, nvmem_priv->size);
+		return -EINVAL;
+	}
+
+	pages = nvmem_priv->size / nvmem_priv->page_size;
+	nvmem_priv->wb_buf = vmalloc(nvmem_priv->size);
+	nvmem_priv->wb_valid = bitmap_zalloc(pages, GFP_KERNEL);
+	nvmem_priv->wb_dirty = bitmap_zalloc(pages, GFP_KERNEL);
+	if (!nvmem_priv->wb_buf || !nvmem_priv->wb_valid || !nvmem_priv->wb_dirty) {
+		OSA_ERROR("Failed to allocate write-back cache\n");
+		goto err_free;
+	}
+
+	OSA_DEBUG("Write-back cache: %u pages of %u bytes, flush delay %u ms\n",
+		  pages, nvmem_priv->page_size, nvmem_priv->flush_delay_ms);
+	return 0;
+
+err_free:
+	bitmap_free(nvmem_priv->wb_dirty);
+	bitmap_free(nvmem_priv->wb_valid);
+	vfree(nvmem_priv->wb_buf);
+	nvmem_priv->wb_buf = NULL;
+	return -ENOMEM;
+}
+
+/**
+ * @brief Flushes and releases the write-back cache.
+ */
+static void pdm_nvmem_wb_exit(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+
+	cancel_delayed_work_sync(&nvmem_priv->flush_work);
+	if (!nvmem_priv->wb_buf) {
+		return;
+	}
+
+	mutex_lock(&nvmem_priv->lock);
+	if (pdm_nvmem_wb_flush(client)) {
+		OSA_ERROR("Failed to flush NVMEM write-back cache, data lost\n");
+	}
+	mutex_unlock(&nvmem_priv->lock);
+
+	bitmap_free(nvmem_priv->wb_dirty);
+	bitmap_free(nvmem_priv->wb_valid);
+	vfree(nvmem_priv->wb_buf);
+	nvmem_priv->wb_buf = NULL;
+}
+
+/**
+ * @brief Shows the write-back statistics.
+ */
+static int pdm_nvmem_stats_show(struct seq_file *s, void *data)
+{
+	struct pdm_client *client = s->private;
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	unsigned int dirty = 0;
+
+	mutex_lock(&nvmem_priv->lock);
+	if (nvmem_priv->wb_buf) {
+		dirty = bitmap_weight(nvmem_priv->wb_dirty, nvmem_priv->size / nvmem_priv->page_size);
+	}
+	seq_printf(s, "page_size:     %u\n", nvmem_priv->page_size);
+	seq_printf(s, "flush_delay:   %u ms\n", nvmem_priv->flush_delay_ms);
+	seq_printf(s, "dirty_pages:   %u\n", dirty);
+	seq_printf(s, "bytes_written: %llu\n", nvmem_priv->stats.bytes_written);
+	seq_printf(s, "pages_dirtied: %llu\n", nvmem_priv->stats.pages_dirtied);
+	seq_printf(s, "page_loads:    %llu\n", nvmem_priv->stats.page_loads);
+	seq_printf(s, "flushes:       %llu\n", nvmem_priv->stats.flushes);
+	seq_printf(s, "pages_flushed: %llu\n", nvmem_priv->stats.pages_flushed);
+	seq_printf(s, "flush_errors:  %llu\n", nvmem_priv->stats.flush_errors);
+	seq_printf(s, "readahead:     %u\n", nvmem_priv->ra_size);
+	seq_printf(s, "ra_prefetches: %llu\n", nvmem_priv->stats.ra_prefetches);
+	seq_printf(s, "ra_hits:       %llu\n", nvmem_priv->stats.ra_hits);
+	if (nvmem_priv->records) {
+		seq_printf(s, "record_bank:   %u (generation %u)\n", nvmem_priv->records->bank,
+			   nvmem_priv->records->generation);
+		seq_printf(s, "record_live:   %u\n", nvmem_priv->records->live);
+		seq_printf(s, "record_used:   %u/%u\n",
+			   nvmem_priv->records->tail - nvmem_priv->records->base
+			   - nvmem_priv->records->bank * nvmem_priv->records->bank_size,
+			   nvmem_priv->records->bank_size);
+		seq_printf(s, "record_writes: %llu\n", nvmem_priv->records->appends);
+		seq_printf(s, "compactions:   %llu\n", nvmem_priv->records->compactions);
+	}
+	mutex_unlock(&nvmem_priv->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(pdm_nvmem_stats);
+
+/**
+ * @brief Syncs or drops the backend cache of a specified PDM NVMEM device.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param cmd PDM_NVMEM_CACHE_SYNC or PDM_NVMEM_CACHE_DROP.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_nvmem_cache_ctrl(struct pdm_client *client, unsigned int cmd)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	int (*op)(struct pdm_client *client);
+	int status;
+
+	op = (cmd == PDM_NVMEM_CACHE_SYNC) ? nvmem_priv->cache_sync : nvmem_priv->cache_drop;
+	if (!op) {
+		OSA_ERROR("cache control not supported\n");
+		return -ENOTSUPP;
+	}
+
+	mutex_lock(&nvmem_priv->lock);
+	status = op(client);
+	if (cmd == PDM_NVMEM_CACHE_DROP) {
+		nvmem_priv->ra_valid = false;
+		nvmem_priv->ra_gen++;
+	}
+	if (!status && cmd == PDM_NVMEM_CACHE_DROP && nvmem_priv->shadow_loaded) {
+		/* The shadow is mapped by userspace, refresh it in place */
+		status = pdm_nvmem_shadow_load(client);
+	}
+	mutex_unlock(&nvmem_priv->lock);
+	if (status) {
+		OSA_ERROR("PDM NVMEM cache %s failed, status: %d\n",
+			  (cmd == PDM_NVMEM_CACHE_SYNC) ? "sync" : "drop", status);
+	}
+
+	return status;
+}
+
 /**
  * @brief Handles IOCTL commands from user space.
  *
@@ -89,7 +514,11 @@ static int pdm_nvmem_write_reg(struct pdm_client *client, unsigned int offset, v
  */
 static long pdm_nvmem_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
-	struct pdm_client *client = filp->private_data;
+	struct pdm_client *client = pdm_nvmem_file_client(filp);
+	struct pdm_nvmem_ioctl_data __user *user_data = (struct pdm_nvmem_ioctl_data __user *)arg;
+	struct pdm_nvmem_priv *nvmem_priv;
+	struct pdm_nvmem_ioctl_data data;
+	struct pdm_nvmem_record record;
 	int status = 0;
 
 	if (!client) {
@@ -97,33 +526,90 @@ static long pdm_nvmem_ioctl(struct file *filp, unsigned int cmd, unsigned long a
 		return -EINVAL;
 	}
 
+	nvmem_priv = pdm_client_get_private_data(client);
+
 	switch (cmd) {
-		case PDM_NVMEM_CMD_WRITE_REG:
+		case PDM_NVMEM_WRITE_REG:
+		{
+			if (copy_from_user(&data, user_data, sizeof(data))) {
+				OSA_ERROR("Failed to copy data from user space\n");
+				return -EFAULT;
+			}
+
+			if (data.addr >= nvmem_priv->size) {
+				OSA_ERROR("Invalid address: 0x%x\n", data.addr);
+				return -EINVAL;
+			}
+
+			mutex_lock(&nvmem_priv->lock);
+			status = pdm_nvmem_xfer_write(client, data.addr, &data.value, sizeof(data.value));
+			mutex_unlock(&nvmem_priv->lock);
+			break;
+		}
+		case PDM_NVMEM_READ_REG:
 		{
-			int level;
-			if (copy_from_user(&level, (void __user *)arg, sizeof(level))) {
+			if (copy_from_user(&data, user_data, sizeof(data))) {
 				OSA_ERROR("Failed to copy data from user space\n");
 				return -EFAULT;
 			}
-			OSA_INFO("PDM_DIMMER: Set %s's level to %d\n", dev_name(&client->dev), level);
-			status = pdm_nvmem_write_reg(client, 0, 0, 0);
+
+			if (data.addr >= nvmem_priv->size) {
+				OSA_ERROR("Invalid address: 0x%x\n", data.addr);
+				return -EINVAL;
+			}
+
+			mutex_lock(&nvmem_priv->lock);
+			status = pdm_nvmem_xfer_read(client, data.addr, &data.value, sizeof(data.value));
+			mutex_unlock(&nvmem_priv->lock);
+			if (status) {
+				OSA_ERROR("Failed to read NVMEM 0x%x, status: %d\n", data.addr, status);
+				return status;
+			}
+
+			if (copy_to_user(user_data, &data, sizeof(data))) {
+				OSA_ERROR("Failed to copy data to user space\n");
+				return -EFAULT;
+			}
 			break;
 		}
-		case PDM_NVMEM_CMD_READ_REG:
+		case PDM_NVMEM_RECORD_GET:
 		{
-			int level;
-			status = pdm_nvmem_read_reg(client, 0, &level, 0);
+			if (copy_from_user(&record, (void __user *)arg, sizeof(record))) {
+				OSA_ERROR("Failed to copy data from user space\n");
+				return -EFAULT;
+			}
+
+			mutex_lock(&nvmem_priv->lock);
+			status = pdm_nvmem_record_get(client, &record);
+			mutex_unlock(&nvmem_priv->lock);
 			if (status) {
-				OSA_ERROR("Failed to get DIMMER level, status: %d\n", status);
 				return status;
 			}
-			OSA_INFO("PDM_DIMMER: Current level is %d\n", level);
-			if (copy_to_user((void __user *)arg, &level, sizeof(level))) {
+
+			if (copy_to_user((void __user *)arg, &record, sizeof(record))) {
 				OSA_ERROR("Failed to copy data to user space\n");
 				return -EFAULT;
 			}
 			break;
 		}
+		case PDM_NVMEM_RECORD_SET:
+		{
+			if (copy_from_user(&record, (void __user *)arg, sizeof(record))) {
+				OSA_ERROR("Failed to copy data from user space\n");
+				return -EFAULT;
+			}
+
+			mutex_lock(&nvmem_priv->lock);
+			status = pdm_nvmem_record_set(client, &record);
+			mutex_unlock(&nvmem_priv->lock);
+			break;
+		}
+		case PDM_NVMEM_CACHE_SYNC:
+		case PDM_NVMEM_CACHE_DROP:
+		{
+			status = pdm_nvmem_cache_ctrl(client, cmd);
+			break;
+		}
 		default:
 		{
 			OSA_ERROR("Unknown ioctl command\n");
@@ -139,110 +625,618 @@ static long pdm_nvmem_ioctl(struct file *filp, unsigned int cmd, unsigned long a
 	return 0;
 }
 
-
 /**
- * @brief Reads information about available commands or NVMEM state/brightness.
+ * @brief Seeks within the NVMEM device, the file offset is the device offset.
  *
  * @param filp File pointer.
- * @param buf User buffer to write data into.
- * @param count Number of bytes to read.
- * @param ppos Offset in the file.
+ * @param offset Seek offset.
+ * @param whence SEEK_SET, SEEK_CUR or SEEK_END.
+ * @return Returns the new position or negative error code on failure.
+ */
+static loff_t pdm_nvmem_llseek(struct file *filp, loff_t offset, int whence)
+{
+	struct pdm_client *client = pdm_nvmem_file_client(filp);
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+
+	return fixed_size_llseek(filp, offset, whence, nvmem_priv->size);
+}
+
+/**
+ * @brief Fills the read-ahead window starting at nvmem_priv->ra_next.
+ *
+ * The unread tail of the current window is kept, only the missing part is read from the
+ * device. The new window is built in the spare buffer, the lock is only held per chunk so
+ * that readers are served in between, and the buffers are swapped once it is complete.
+ * A write, cache drop or resize in the meantime bumps ra_gen and discards the prefetch.
+ */
+static void pdm_nvmem_ra_work_func(struct work_struct *work)
+{
+	struct pdm_nvmem_priv *nvmem_priv = container_of(work, struct pdm_nvmem_priv, ra_work);
+	unsigned int pos, end, done, len, gen;
+	int status = 0;
+	void *fill;
+
+	mutex_lock(&nvmem_priv->lock);
+	if (!nvmem_priv->ra_buf || nvmem_priv->ra_next >= nvmem_priv->size) {
+		mutex_unlock(&nvmem_priv->lock);
+		return;
+	}
+
+	pos = nvmem_priv->ra_next;
+	end = min_t(unsigned int, pos + nvmem_priv->ra_size, nvmem_priv->size);
+	fill = nvmem_priv->ra_fill;
+	gen = nvmem_priv->ra_gen;
+	done = 0;
+	if (nvmem_priv->ra_valid && pos >= nvmem_priv->ra_start
+	    && pos < nvmem_priv->ra_start + nvmem_priv->ra_len) {
+		done = min(nvmem_priv->ra_start + nvmem_priv->ra_len, end) - pos;
+		memcpy(fill, nvmem_priv->ra_buf + (pos - nvmem_priv->ra_start), done);
+	}
+	mutex_unlock(&nvmem_priv->lock);
+
+	while (!status && pos + done < end) {
+		len = min_t(unsigned int, end - pos - done, PDM_NVMEM_XFER_CHUNK);
+		mutex_lock(&nvmem_priv->lock);
+		if (nvmem_priv->ra_gen != gen) {
+			status = -EAGAIN;
+		} else {
+			status = pdm_nvmem_xfer_read(nvmem_priv->client, pos + done, fill + done, len);
+		}
+		mutex_unlock(&nvmem_priv->lock);
+		done += len;
+	}
+
+	mutex_lock(&nvmem_priv->lock);
+	if (!status && nvmem_priv->ra_gen == gen) {
+		nvmem_priv->ra_fill = nvmem_priv->ra_buf;
+		nvmem_priv->ra_buf = fill;
+		nvmem_priv->ra_start = pos;
+		nvmem_priv->ra_len = end - pos;
+		nvmem_priv->ra_valid = true;
+		nvmem_priv->stats.ra_prefetches++;
+	} else if (status && status != -EAGAIN) {
+		OSA_WARN("NVMEM read-ahead at 0x%x failed, status: %d\n", pos, status);
+	}
+	mutex_unlock(&nvmem_priv->lock);
+}
+
+/**
+ * @brief Starts prefetching the window at @pos after a sequential read ended there.
+ *
+ * A new window is only requested once the reader has consumed half of the current one,
+ * the new window starts at @pos and reuses the unread tail of the old one.
+ */
+static void pdm_nvmem_ra_kick(struct pdm_client *client, unsigned int pos)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+
+	mutex_lock(&nvmem_priv->lock);
+	if (nvmem_priv->ra_buf && !nvmem_priv->shadow_loaded && pos < nvmem_priv->size
+		&& !(nvmem_priv->ra_valid && pos >= nvmem_priv->ra_start
+		     && pos < nvmem_priv->ra_start + nvmem_priv->ra_len / 2)) {
+		nvmem_priv->ra_next = pos;
+		queue_work(system_unbound_wq, &nvmem_priv->ra_work);
+	}
+	mutex_unlock(&nvmem_priv->lock);
+}
+
+/**
+ * @brief Replaces the read-ahead window with one of @size bytes, 0 disables read-ahead.
+ */
+static int pdm_nvmem_ra_resize(struct pdm_client *client, unsigned int size)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	void *buf = NULL, *fill = NULL;
+	void *old, *old_fill;
+
+	if (size > PDM_NVMEM_READAHEAD_MAX) {
+		OSA_ERROR("Read-ahead size %u exceeds %u\n", size, PDM_NVMEM_READAHEAD_MAX);
+		return -EINVAL;
+	}
+
+	if (size) {
+		buf = kvmalloc(size, GFP_KERNEL);
+		fill = kvmalloc(size, GFP_KERNEL);
+		if (!buf || !fill) {
+			kvfree(fill);
+			kvfree(buf);
+			return -ENOMEM;
+		}
+	}
+
+	/* A prefetch in flight sees ra_gen change and drops its spare buffer contents */
+	mutex_lock(&nvmem_priv->lock);
+	old = nvmem_priv->ra_buf;
+	old_fill = nvmem_priv->ra_fill;
+	nvmem_priv->ra_buf = buf;
+	nvmem_priv->ra_fill = fill;
+	nvmem_priv->ra_size = size;
+	nvmem_priv->ra_valid = false;
+	nvmem_priv->ra_gen++;
+	mutex_unlock(&nvmem_priv->lock);
+
+	kvfree(old_fill);
+	kvfree(old);
+	return 0;
+}
+
+static ssize_t readahead_size_show(struct device *dev, struct device_attribute *da, char *buf)
+{
+	struct pdm_client *client = to_pdm_client_dev(dev);
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+
+	return sysfs_emit(buf, "%u\n", nvmem_priv->ra_size);
+}
+
+static ssize_t readahead_size_store(struct device *dev, struct device_attribute *da, const char *buf, size_t count)
+{
+	struct pdm_client *client = to_pdm_client_dev(dev);
+	unsigned int size;
+	int status;
+
+	status = kstrtouint(buf, 0, &size);
+	if (status) {
+		return status;
+	}
+
+	status = pdm_nvmem_ra_resize(client, size);
+	return status ? status : count;
+}
+static DEVICE_ATTR_RW(readahead_size);
+
+static struct attribute *pdm_nvmem_attrs[] = {
+	&dev_attr_readahead_size.attr,
+	NULL,
+};
+
+static const struct attribute_group pdm_nvmem_attr_group = {
+	.attrs = pdm_nvmem_attrs,
+};
+
+/**
+ * @brief Reads the read-ahead chunk of a stream into its spare buffer.
+ */
+static void pdm_nvmem_readahead_work_func(struct work_struct *work)
+{
+	struct pdm_nvmem_stream *stream = container_of(work, struct pdm_nvmem_stream, work);
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(stream->client);
+
+	mutex_lock(&nvmem_priv->lock);
+	stream->ra_status = pdm_nvmem_xfer_read(stream->client, stream->ra_pos,
+						stream->buf[stream->ra_idx], stream->ra_len);
+	mutex_unlock(&nvmem_priv->lock);
+}
+
+/**
+ * @brief Allocates the streaming read buffers, chunks are a multiple of the page size.
+ */
+static int pdm_nvmem_stream_init(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_stream *stream = &nvmem_priv->stream;
+
+	mutex_init(&nvmem_priv->stream_lock);
+	stream->client = client;
+	stream->chunk = PDM_NVMEM_XFER_CHUNK;
+	if (nvmem_priv->page_size && nvmem_priv->page_size < PDM_NVMEM_XFER_CHUNK) {
+		stream->chunk = rounddown(PDM_NVMEM_XFER_CHUNK, nvmem_priv->page_size);
+	}
+	INIT_WORK(&stream->work, pdm_nvmem_readahead_work_func);
+
+	stream->buf[0] = kmalloc(stream->chunk, GFP_KERNEL);
+	stream->buf[1] = kmalloc(stream->chunk, GFP_KERNEL);
+	if (!stream->buf[0] || !stream->buf[1]) {
+		OSA_ERROR("Failed to allocate stream buffers\n");
+		kfree(stream->buf[1]);
+		kfree(stream->buf[0]);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void pdm_nvmem_stream_exit(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+
+	kfree(nvmem_priv->stream.buf[1]);
+	kfree(nvmem_priv->stream.buf[0]);
+}
+
+/**
+ * @brief Sets up the streaming buffers and read-ahead, the window size comes from the DT
+ * "readahead-size" property.
+ */
+static int pdm_nvmem_ra_init(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct device_node *np = pdm_client_get_of_node(client);
+	unsigned int size;
+	int status;
+
+	INIT_WORK(&nvmem_priv->ra_work, pdm_nvmem_ra_work_func);
+
+	status = pdm_nvmem_stream_init(client);
+	if (status) {
+		return status;
+	}
+
+	if (np && !of_property_read_u32(np, "readahead-size", &size)) {
+		status = pdm_nvmem_ra_resize(client, size);
+		if (status) {
+			goto err_stream_exit;
+		}
+	}
+
+	status = sysfs_create_group(&client->dev.kobj, &pdm_nvmem_attr_group);
+	if (status) {
+		OSA_ERROR("Failed to create NVMEM sysfs attributes, status: %d\n", status);
+		pdm_nvmem_ra_resize(client, 0);
+		goto err_stream_exit;
+	}
+
+	return 0;
+
+err_stream_exit:
+	pdm_nvmem_stream_exit(client);
+	return status;
+}
+
+/**
+ * @brief Removes the read-ahead controls and releases the window.
+ */
+static void pdm_nvmem_ra_exit(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+
+	sysfs_remove_group(&client->dev.kobj, &pdm_nvmem_attr_group);
+	cancel_work_sync(&nvmem_priv->ra_work);
+	pdm_nvmem_ra_resize(client, 0);
+	pdm_nvmem_stream_exit(client);
+}
+
+/**
+ * @brief Returns the length of the stream chunk at @pos, chunks end on chunk boundaries.
+ */
+static size_t pdm_nvmem_stream_len(struct pdm_nvmem_stream *stream, loff_t pos, size_t remaining)
+{
+	/* @pos is bounded by the device size, a 32-bit modulo avoids a 64-bit division */
+	return min_t(size_t, remaining, stream->chunk - ((unsigned int)pos % stream->chunk));
+}
+
+/**
+ * @brief Reads NVMEM contents starting at the file offset.
+ *
+ * Serves read(), and splice()/sendfile() through the generic splice helper. The range is
+ * read in page aligned chunks, the next chunk is read ahead by a work item while the current
+ * one is copied out, so the bus and the consumer work in parallel.
+ *
+ * A read that starts where the previous read on the same file ended is sequential, the
+ * client then prefetches the following window while userspace processes this one.
+ *
+ * @param iocb I/O control block, ki_pos is the device offset.
+ * @param to Destination iterator.
  * @return Returns number of bytes read or negative error code on failure.
  */
-static ssize_t pdm_nvmem_read(struct file *filp, char __user *buf, size_t count, loff_t *ppos)
+static ssize_t pdm_nvmem_read_iter(struct kiocb *iocb, struct iov_iter *to)
 {
-	const char help_info[] =
-		"Available commands:\n"
-		" > 1		- Read NVMEM Reg\n"
-		" > 2		- Write NVMEM Reg\n";
-	size_t len = strlen(help_info);
+	struct file *filp = iocb->ki_filp;
+	struct pdm_nvmem_file *nvmem_file = filp->private_data;
+	struct pdm_client *client = nvmem_file->client;
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_stream *stream;
+	loff_t pos = iocb->ki_pos;
+	bool sequential;
+	size_t count = iov_iter_count(to);
+	size_t done = 0;
+	size_t copied;
+	size_t len;
+	unsigned int idx = 0;
+	bool pending = false;
+	int status;
 
-	if (*ppos >= len)
+	if (pos < 0) {
+		return -EINVAL;
+	}
+
+	if (pos >= nvmem_priv->size || !count) {
 		return 0;
+	}
 
-	// 使用min_t宏指定类型为size_t
-	size_t remaining = min_t(size_t, count, len - *ppos);
+	count = min_t(size_t, count, nvmem_priv->size - pos);
+	/* A fresh file reading from the start counts as sequential as well */
+	sequential = (pos == nvmem_file->last_end);
 
-	if (copy_to_user(buf, help_info + *ppos, remaining))
-		return -EFAULT;
+	stream = &nvmem_priv->stream;
+	mutex_lock(&nvmem_priv->stream_lock);
 
-	*ppos += remaining;
-	return remaining;
+	len = pdm_nvmem_stream_len(stream, pos, count);
+	mutex_lock(&nvmem_priv->lock);
+	status = pdm_nvmem_xfer_read(client, pos, stream->buf[idx], len);
+	mutex_unlock(&nvmem_priv->lock);
+
+	while (!status) {
+		if (done + len < count) {
+			stream->ra_idx = idx ^ 1;
+			stream->ra_pos = pos + done + len;
+			stream->ra_len = pdm_nvmem_stream_len(stream, stream->ra_pos, count - done - len);
+			queue_work(system_unbound_wq, &stream->work);
+			pending = true;
+		}
+
+		copied = copy_to_iter(stream->buf[idx], len, to);
+		done += copied;
+		if (copied != len) {
+			status = -EFAULT;
+			break;
+		}
+
+		if (!pending) {
+			break;
+		}
+
+		flush_work(&stream->work);
+		pending = false;
+		status = stream->ra_status;
+		len = stream->ra_len;
+		idx ^= 1;
+	}
+
+	if (pending) {
+		flush_work(&stream->work);
+	}
+	mutex_unlock(&nvmem_priv->stream_lock);
+
+	iocb->ki_pos = pos + done;
+	if (done) {
+		nvmem_file->last_end = pos + done;
+		if (sequential) {
+			pdm_nvmem_ra_kick(client, pos + done);
+		}
+	}
+	return done ? done : status;
 }
 
 /**
- * @brief Writes commands to change NVMEM state or brightness.
+ * @brief Writes NVMEM contents starting at the file offset.
  *
  * @param filp File pointer.
- * @param buf User buffer containing command data.
+ * @param buf User buffer containing the data.
  * @param count Number of bytes to write.
  * @param ppos Offset in the file.
  * @return Returns number of bytes written or negative error code on failure.
  */
 static ssize_t pdm_nvmem_write(struct file *filp, const char __user *buf, size_t count, loff_t *ppos)
 {
-	struct pdm_client *client = filp->private_data;
-	char kernel_buf[64];
-	ssize_t bytes_read;
-	char buffer[32];
-	unsigned int offset = 0;
-	unsigned char value = 0x0;
-	int cmd;
+	struct pdm_client *client = pdm_nvmem_file_client(filp);
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	loff_t pos = *ppos;
+	size_t done = 0;
+	size_t chunk;
+	void *bounce;
+	int status = 0;
 
-	if (!client || count >= sizeof(kernel_buf)) {
-		OSA_ERROR("Invalid client or input too long.\n");
+	if (pos < 0) {
 		return -EINVAL;
 	}
 
-	if ((bytes_read = copy_from_user(kernel_buf, buf, count)) != 0) {
-		OSA_ERROR("Failed to copy data from user space: %zd\n", bytes_read);
-		return -EFAULT;
+	if (!count) {
+		return 0;
 	}
 
-	kernel_buf[count] = '\0';
-	if (sscanf(kernel_buf, "%d", &cmd) != 1) {
-		OSA_ERROR("Invalid command format: %s\n", kernel_buf);
-		return -EINVAL;
+	if (pos >= nvmem_priv->size) {
+		return -ENOSPC;
 	}
 
-	switch (cmd)
-	{
-		case PDM_NVMEM_CMD_WRITE_REG:
-		{
-			if (sscanf(kernel_buf, "%d 0x%x 0x%hhx", &cmd, &offset, &value) != 3) {
-				OSA_ERROR("Command %d requires one parameter.\n", cmd);
-				return -EINVAL;
-			}
+	count = min_t(size_t, count, nvmem_priv->size - pos);
+	bounce = kmalloc(min_t(size_t, count, PDM_NVMEM_XFER_CHUNK), GFP_KERNEL);
+	if (!bounce) {
+		return -ENOMEM;
+	}
 
-			if (pdm_nvmem_write_reg(client, offset, &value, 1)) {
-				OSA_ERROR("pdm_nvmem_set_state failed\n");
-				return -EINVAL;
-			}
+	mutex_lock(&nvmem_priv->lock);
+	while (done < count) {
+		chunk = min_t(size_t, count - done, PDM_NVMEM_XFER_CHUNK);
+		if (copy_from_user(bounce, buf + done, chunk)) {
+			status = -EFAULT;
 			break;
 		}
-		case PDM_NVMEM_CMD_READ_REG:
-		{
-			if (sscanf(kernel_buf, "%d 0x%x", &cmd, &offset) != 2) {
-				OSA_ERROR("Command %d should not have parameters.\n", cmd);
-				return -EINVAL;
-			}
 
-			if (pdm_nvmem_read_reg(client, offset, &value, 1)) {
-				OSA_ERROR("pdm_nvmem_get_state failed\n");
-				return -EINVAL;
-			}
-			snprintf(buffer, sizeof(buffer), "%d\n", value);
-			bytes_read = simple_read_from_buffer((void __user *)buf, strlen(buffer), ppos, buffer, strlen(buffer));
-			return bytes_read;
-		}
-		default:
-		{
-			OSA_ERROR("Unknown command: %d\n", cmd);
-			return -EINVAL;
+		status = pdm_nvmem_xfer_write(client, pos + done, bounce, chunk);
+		if (status) {
+			break;
 		}
+		done += chunk;
 	}
+	mutex_unlock(&nvmem_priv->lock);
+
+	kfree(bounce);
+	*ppos = pos + done;
+	return done ? done : status;
+}
+
+/**
+ * @brief nvmem provider read callback.
+ */
+static int pdm_nvmem_provider_read(void *priv, unsigned int offset, void *val, size_t bytes)
+{
+	struct pdm_client *client = priv;
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	int status;
+
+	mutex_lock(&nvmem_priv->lock);
+	status = pdm_nvmem_xfer_read(client, offset, val, bytes);
+	mutex_unlock(&nvmem_priv->lock);
+
+	return status;
+}
+
+/**
+ * @brief nvmem provider write callback.
+ */
+static int pdm_nvmem_provider_write(void *priv, unsigned int offset, void *val, size_t bytes)
+{
+	struct pdm_client *client = priv;
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	int status;
+
+	mutex_lock(&nvmem_priv->lock);
+	status = pdm_nvmem_xfer_write(client, offset, val, bytes);
+	mutex_unlock(&nvmem_priv->lock);
 
-	return count;
+	return status;
+}
+
+/**
+ * @brief Registers the client with the kernel nvmem framework.
+ *
+ * The provider is attached to the bus device so that the cells described in its DT node
+ * can be looked up by other drivers. Accesses go through the same path as the char device,
+ * keeping the write-back cache and the shadow coherent.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_nvmem_provider_register(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct device_node *np = pdm_client_get_of_node(client);
+	struct nvmem_config config;
+	int status;
+
+	if (!nvmem_priv->size || !nvmem_priv->read_reg) {
+		return 0;
+	}
+
+	memset(&config, 0, sizeof(config));
+	config.name = dev_name(&client->dev);
+	config.id = NVMEM_DEVID_NONE;
+	config.owner = THIS_MODULE;
+	config.dev = client->pdmdev->dev.parent;
+	config.priv = client;
+	config.size = nvmem_priv->size;
+	config.word_size = 1;
+	config.stride = 1;
+	config.read_only = !nvmem_priv->write_reg || (np && of_property_read_bool(np, "read-only"));
+	config.reg_read = pdm_nvmem_provider_read;
+	config.reg_write = pdm_nvmem_provider_write;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 6, 0)
+	/* Cells placed directly under the provider node are only parsed on request since 6.6 */
+	config.add_legacy_fixed_of_cells = true;
+#endif
+
+	nvmem_priv->nvmem = nvmem_register(&config);
+	if (IS_ERR(nvmem_priv->nvmem)) {
+		status = PTR_ERR(nvmem_priv->nvmem);
+		nvmem_priv->nvmem = NULL;
+		return status;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Maps the shadow image of the device read-only.
+ *
+ * The shadow is loaded on first use and kept coherent with writes through the adapter.
+ *
+ * @param filp File pointer.
+ * @param vma Virtual memory area to map into.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_nvmem_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct pdm_client *client = pdm_nvmem_file_client(filp);
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	int status = 0;
+
+	if (vma->vm_flags & VM_WRITE) {
+		return -EPERM;
+	}
+
+	mutex_lock(&nvmem_priv->lock);
+	if (!nvmem_priv->shadow_loaded) {
+		status = pdm_nvmem_shadow_load(client);
+	}
+	mutex_unlock(&nvmem_priv->lock);
+	if (status) {
+		return status;
+	}
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 3, 0)
+	vma->vm_flags &= ~VM_MAYWRITE;
+#else
+	vm_flags_clear(vma, VM_MAYWRITE);
+#endif
+
+	/* Mapped pages hold their own reference, the shadow may be freed while mapped */
+	return remap_vmalloc_range(vma, nvmem_priv->shadow, vma->vm_pgoff);
+}
+
+/**
+ * @brief Flushes the write-back cache to the device.
+ *
+ * @param filp File pointer.
+ * @param start Start of the range to sync, the whole device is flushed.
+ * @param end End of the range to sync.
+ * @param datasync Only flush data.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_nvmem_fsync(struct file *filp, loff_t start, loff_t end, int datasync)
+{
+	struct pdm_client *client = pdm_nvmem_file_client(filp);
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	int status;
+
+	mutex_lock(&nvmem_priv->lock);
+	status = pdm_nvmem_wb_flush(client);
+	mutex_unlock(&nvmem_priv->lock);
+
+	return status;
+}
+
+/**
+ * @brief Allocates the per-open state of the file.
+ *
+ * @param inode Pointer to the inode structure.
+ * @param filp File pointer.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_nvmem_open(struct inode *inode, struct file *filp)
+{
+	struct pdm_nvmem_file *nvmem_file;
+
+	nvmem_file = kzalloc(sizeof(*nvmem_file), GFP_KERNEL);
+	if (!nvmem_file) {
+		return -ENOMEM;
+	}
+
+	/* A fresh file reading from the start counts as sequential as well */
+	nvmem_file->client = container_of(inode->i_cdev, struct pdm_client, cdev);
+	nvmem_file->last_end = 0;
+	filp->private_data = nvmem_file;
+
+	return 0;
+}
+
+/**
+ * @brief Flushes the write-back cache and frees the per-open state when the file is closed.
+ *
+ * @param inode Pointer to the inode structure.
+ * @param filp File pointer.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_nvmem_release(struct inode *inode, struct file *filp)
+{
+	int status;
+
+	status = pdm_nvmem_fsync(filp, 0, LLONG_MAX, 0);
+	if (status) {
+		OSA_ERROR("Failed to flush NVMEM on close, status: %d\n", status);
+	}
+
+	kfree(filp->private_data);
+	return status;
 }
 
 /**
@@ -255,6 +1249,8 @@ static ssize_t pdm_nvmem_write(struct file *filp, const char __user *buf, size_t
  */
 static int pdm_nvmem_device_probe(struct pdm_device *pdmdev)
 {
+	struct pdm_nvmem_priv *nvmem_priv;
+	struct device_node *np;
 	struct pdm_client *client;
 	int status;
 
@@ -264,6 +1260,16 @@ static int pdm_nvmem_device_probe(struct pdm_device *pdmdev)
 		return PTR_ERR(client);
 	}
 
+	nvmem_priv = pdm_client_get_private_data(client);
+	nvmem_priv->client = client;
+	mutex_init(&nvmem_priv->lock);
+
+	np = pdm_client_get_of_node(client);
+	if (!np || of_property_read_u32(np, "size", &nvmem_priv->size)) {
+		OSA_WARN("No size property found, read/write disabled\n");
+		nvmem_priv->size = 0;
+	}
+
 	status = devm_pdm_client_register(nvmem_adapter, client);
 	if (status) {
 		OSA_ERROR("NVMEM Adapter Add Device Failed, status=%d\n", status);
@@ -276,9 +1282,62 @@ static int pdm_nvmem_device_probe(struct pdm_device *pdmdev)
 		return status;
 	}
 
-	client->fops.read = pdm_nvmem_read;
+	status = pdm_nvmem_wb_init(client);
+	if (status) {
+		OSA_ERROR("NVMEM Write-back Cache Init Failed, status=%d\n", status);
+		pdm_client_cleanup(client);
+		return status;
+	}
+
+	status = pdm_nvmem_ra_init(client);
+	if (status) {
+		OSA_ERROR("NVMEM Read-ahead Init Failed, status=%d\n", status);
+		pdm_nvmem_wb_exit(client);
+		pdm_client_cleanup(client);
+		return status;
+	}
+
+	mutex_lock(&nvmem_priv->lock);
+	status = pdm_nvmem_record_init(client);
+	mutex_unlock(&nvmem_priv->lock);
+	if (status) {
+		OSA_WARN("NVMEM record store unavailable, status=%d\n", status);
+	}
+
+	if (np && of_property_read_bool(np, "shadow-preload")) {
+		mutex_lock(&nvmem_priv->lock);
+		status = pdm_nvmem_shadow_load(client);
+		mutex_unlock(&nvmem_priv->lock);
+		if (status) {
+			OSA_WARN("NVMEM shadow preload failed, loading on first mmap\n");
+		}
+	}
+
+	status = pdm_nvmem_provider_register(client);
+	if (status) {
+		OSA_WARN("Failed to register nvmem provider, status=%d, in-kernel consumers disabled\n", status);
+	}
+
+	nvmem_priv->debugfs = debugfs_create_file(dev_name(&client->dev), 0444, pdm_debugfs_get_dir(),
+						  client, &pdm_nvmem_stats_fops);
+
+	client->fops.open = pdm_nvmem_open;
+	client->fops.llseek = pdm_nvmem_llseek;
+	client->fops.release = pdm_nvmem_release;
+	client->fops.fsync = pdm_nvmem_fsync;
+	client->fops.mmap = pdm_nvmem_mmap;
+	client->fops.read = NULL;
+	client->fops.read_iter = pdm_nvmem_read_iter;
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 5, 0)
+	client->fops.splice_read = generic_file_splice_read;
+#else
+	client->fops.splice_read = copy_splice_read;
+#endif
 	client->fops.write = pdm_nvmem_write;
 	client->fops.unlocked_ioctl = pdm_nvmem_ioctl;
+	/* private_data holds the per-open state, not the client the defaults expect */
+	client->fops.compat_ioctl = compat_ptr_ioctl;
+	client->fops.poll = NULL;
 
 	return 0;
 }
@@ -292,8 +1351,21 @@ static int pdm_nvmem_device_probe(struct pdm_device *pdmdev)
  */
 static void pdm_nvmem_device_remove(struct pdm_device *pdmdev)
 {
+	struct pdm_nvmem_priv *nvmem_priv;
+
 	if (pdmdev && pdmdev->client) {
+		nvmem_priv = pdm_client_get_private_data(pdmdev->client);
+		debugfs_remove(nvmem_priv->debugfs);
+		if (nvmem_priv->nvmem) {
+			nvmem_unregister(nvmem_priv->nvmem);
+		}
+		pdm_nvmem_ra_exit(pdmdev->client);
+		pdm_nvmem_wb_exit(pdmdev->client);
+		pdm_nvmem_record_exit(pdmdev->client);
 		pdm_client_cleanup(pdmdev->client);
+		nvmem_priv->shadow_loaded = false;
+		vfree(nvmem_priv->shadow);
+		nvmem_priv->shadow = NULL;
 	}
 }
 
@@ -304,6 +1376,7 @@ static void pdm_nvmem_device_remove(struct pdm_device *pdmdev)
  */
 static const struct of_device_id of_pdm_nvmem_match[] = {
 	{ .compatible = "pdm-nvmem-spi",	 .data = &pdm_nvmem_spi_match_data},
+	{ .compatible = "pdm-nvmem-i2c",	 .data = &pdm_nvmem_i2c_match_data},
 	{},
 };
 MODULE_DEVICE_TABLE(of, of_pdm_nvmem_match);
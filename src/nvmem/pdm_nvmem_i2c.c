@@ -0,0 +1,264 @@
+#include <linux/i2c.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+
+#include "pdm.h"
+#include "pdm_nvmem_priv.h"
+
+#define PDM_NVMEM_I2C_PAGE_SIZE			(8)	/* Default page size (24C01/02) */
+#define PDM_NVMEM_I2C_ADDRESS_WIDTH		(8)	/* Default address width in bits */
+#define PDM_NVMEM_I2C_WRITE_TIMEOUT_MS		(25)	/* Write cycle timeout (ms) */
+#define PDM_NVMEM_I2C_BLOCK_SIZE		(256)	/* Bytes covered by one bus address with 8-bit addressing */
+#define PDM_NVMEM_I2C_MAX_ADDR_BYTES		(2)	/* Maximum number of address bytes */
+
+/**
+ * @brief I2C EEPROM driver private data.
+ */
+struct pdm_nvmem_i2c_data {
+	unsigned int page_size;		/* Write page size in bytes */
+	unsigned int addr_bytes;	/* Number of address bytes sent before the data */
+	unsigned int write_timeout_ms;	/* Upper bound of the internal write cycle */
+	size_t max_read_len;		/* Longest read message accepted by the adapter */
+	u8 *buf;			/* Address + page write buffer */
+};
+
+/**
+ * @brief Returns the bus address and in-block word address of a device offset.
+ *
+ * With one address byte, parts larger than 256 bytes carry the upper offset bits in the
+ * low bits of the slave address (24C04/08/16).
+ */
+static u16 pdm_nvmem_i2c_addr(struct pdm_client *client, struct pdm_nvmem_i2c_data *i2c_data,
+			      unsigned int offset, u8 *addr_buf)
+{
+	struct i2c_client *i2c = client->hardware.i2c.client;
+
+	if (i2c_data->addr_bytes == 1) {
+		addr_buf[0] = offset & 0xFF;
+		return i2c->addr + (offset / PDM_NVMEM_I2C_BLOCK_SIZE);
+	}
+
+	addr_buf[0] = (offset >> 8) & 0xFF;
+	addr_buf[1] = offset & 0xFF;
+	return i2c->addr;
+}
+
+/**
+ * @brief Sequential read of one block, a single combined transfer.
+ */
+static int pdm_nvmem_i2c_read_block(struct pdm_client *client, unsigned int offset, void *val, size_t bytes)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_i2c_data *i2c_data = nvmem_priv->hw_priv;
+	u8 addr_buf[PDM_NVMEM_I2C_MAX_ADDR_BYTES];
+	struct i2c_msg msgs[2];
+	u16 addr;
+
+	addr = pdm_nvmem_i2c_addr(client, i2c_data, offset, addr_buf);
+
+	msgs[0].addr = addr;
+	msgs[0].flags = 0;
+	msgs[0].len = i2c_data->addr_bytes;
+	msgs[0].buf = addr_buf;
+
+	msgs[1].addr = addr;
+	msgs[1].flags = I2C_M_RD;
+	msgs[1].len = bytes;
+	msgs[1].buf = val;
+
+	return (ARRAY_SIZE(msgs) == i2c_transfer(client->hardware.i2c.client->adapter, msgs, ARRAY_SIZE(msgs)))
+		? 0 : -EREMOTEIO;
+}
+
+/**
+ * @brief Waits for the internal write cycle by ACK polling.
+ *
+ * The part does not acknowledge its address while programming, a current address read
+ * of one byte succeeds as soon as the write cycle has completed.
+ */
+static int pdm_nvmem_i2c_wait_ready(struct pdm_client *client, u16 addr)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_i2c_data *i2c_data = nvmem_priv->hw_priv;
+	ktime_t timeout = ktime_add_ms(ktime_get(), i2c_data->write_timeout_ms);
+	struct i2c_msg msg;
+	u8 dummy;
+	bool expired;
+
+	msg.addr = addr;
+	msg.flags = I2C_M_RD;
+	msg.len = sizeof(dummy);
+	msg.buf = &dummy;
+
+	do {
+		expired = ktime_after(ktime_get(), timeout);
+		if (i2c_transfer(client->hardware.i2c.client->adapter, &msg, 1) == 1) {
+			return 0;
+		}
+		usleep_range(50, 100);
+	} while (!expired);
+
+	OSA_ERROR("Write cycle timeout at bus address 0x%02x\n", addr);
+	return -ETIMEDOUT;
+}
+
+/**
+ * @brief Programs data that lies within a single page.
+ */
+static int pdm_nvmem_i2c_write_page(struct pdm_client *client, unsigned int offset, const void *val, size_t bytes)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_i2c_data *i2c_data = nvmem_priv->hw_priv;
+	struct i2c_msg msg;
+	u16 addr;
+
+	addr = pdm_nvmem_i2c_addr(client, i2c_data, offset, i2c_data->buf);
+	memcpy(i2c_data->buf + i2c_data->addr_bytes, val, bytes);
+
+	msg.addr = addr;
+	msg.flags = 0;
+	msg.len = i2c_data->addr_bytes + bytes;
+	msg.buf = i2c_data->buf;
+
+	if (i2c_transfer(client->hardware.i2c.client->adapter, &msg, 1) != 1) {
+		OSA_ERROR("Page write at 0x%x failed\n", offset);
+		return -EREMOTEIO;
+	}
+
+	return pdm_nvmem_i2c_wait_ready(client, addr);
+}
+
+/**
+ * @brief Reads a block, split where the bus address changes or a message would be too long.
+ */
+static int pdm_nvmem_i2c_read_reg(struct pdm_client *client, unsigned int offset, void *val, size_t bytes)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_i2c_data *i2c_data = nvmem_priv->hw_priv;
+	size_t done = 0;
+	size_t len;
+	int status;
+
+	while (done < bytes) {
+		len = bytes - done;
+		if (i2c_data->addr_bytes == 1) {
+			len = min_t(size_t, len, PDM_NVMEM_I2C_BLOCK_SIZE - (offset + done) % PDM_NVMEM_I2C_BLOCK_SIZE);
+		}
+		len = min_t(size_t, len, i2c_data->max_read_len);
+
+		status = pdm_nvmem_i2c_read_block(client, offset + done, val + done, len);
+		if (status) {
+			OSA_ERROR("Sequential read at 0x%zx failed\n", (size_t)offset + done);
+			return status;
+		}
+		done += len;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Writes a block as a sequence of page writes.
+ */
+static int pdm_nvmem_i2c_write_reg(struct pdm_client *client, unsigned int offset, void *val, size_t bytes)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_i2c_data *i2c_data = nvmem_priv->hw_priv;
+	size_t done = 0;
+	size_t len;
+	int status;
+
+	while (done < bytes) {
+		len = min_t(size_t, bytes - done, i2c_data->page_size - (offset + done) % i2c_data->page_size);
+		status = pdm_nvmem_i2c_write_page(client, offset + done, val + done, len);
+		if (status) {
+			return status;
+		}
+		done += len;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Initializes an I2C EEPROM (24Cxx) NVMEM client.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_nvmem_i2c_setup(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_i2c_data *i2c_data;
+	const struct i2c_adapter_quirks *quirks;
+	struct device_node *np;
+	unsigned int address_width;
+
+	if (!client || !nvmem_priv) {
+		OSA_ERROR("Invalid client\n");
+		return -EINVAL;
+	}
+
+	np = pdm_client_get_of_node(client);
+	if (!np) {
+		OSA_ERROR("No DT node found\n");
+		return -EINVAL;
+	}
+
+	i2c_data = devm_kzalloc(&client->pdmdev->dev, sizeof(*i2c_data), GFP_KERNEL);
+	if (!i2c_data) {
+		OSA_ERROR("Failed to allocate I2C NVMEM data\n");
+		return -ENOMEM;
+	}
+
+	if (of_property_read_u32(np, "pagesize", &i2c_data->page_size) || !i2c_data->page_size) {
+		i2c_data->page_size = PDM_NVMEM_I2C_PAGE_SIZE;
+	}
+
+	if (of_property_read_u32(np, "address-width", &address_width)) {
+		address_width = PDM_NVMEM_I2C_ADDRESS_WIDTH;
+	}
+	if (address_width != 8 && address_width != 16) {
+		OSA_ERROR("Unsupported address-width: %u\n", address_width);
+		return -EINVAL;
+	}
+	i2c_data->addr_bytes = address_width / 8;
+
+	if (of_property_read_u32(np, "write-timeout-ms", &i2c_data->write_timeout_ms)) {
+		i2c_data->write_timeout_ms = PDM_NVMEM_I2C_WRITE_TIMEOUT_MS;
+	}
+
+	i2c_data->buf = devm_kzalloc(&client->pdmdev->dev, i2c_data->addr_bytes + i2c_data->page_size, GFP_KERNEL);
+	if (!i2c_data->buf) {
+		OSA_ERROR("Failed to allocate page buffer\n");
+		return -ENOMEM;
+	}
+
+	client->hardware.i2c.client = to_i2c_client(client->pdmdev->dev.parent);
+	quirks = client->hardware.i2c.client->adapter->quirks;
+	/* i2c_msg.len is 16 bits wide, adapters may accept even less */
+	i2c_data->max_read_len = U16_MAX;
+	if (quirks && quirks->max_read_len) {
+		i2c_data->max_read_len = min_t(size_t, i2c_data->max_read_len, quirks->max_read_len);
+	}
+	nvmem_priv->hw_priv = i2c_data;
+	nvmem_priv->read_reg = pdm_nvmem_i2c_read_reg;
+	nvmem_priv->write_reg = pdm_nvmem_i2c_write_reg;
+
+	OSA_DEBUG("I2C NVMEM Setup: %s, page %u, %u-bit address\n", dev_name(&client->dev),
+		  i2c_data->page_size, address_width);
+	return 0;
+}
+
+static void pdm_nvmem_i2c_cleanup(struct pdm_client *client)
+{
+	return;
+}
+
+/**
+ * @brief Match data structure for initializing I2C type NVMEM devices.
+ */
+const struct pdm_client_match_data pdm_nvmem_i2c_match_data = {
+	.setup = pdm_nvmem_i2c_setup,
+	.cleanup = pdm_nvmem_i2c_cleanup,
+};
@@ -9,7 +9,12 @@
  * used to manage and operate PDM NVMEM devices.
  */
 
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/xarray.h>
+
 #include "pdm.h"
+#include "pdm_nvmem_ioctl.h"
 
 /**
  * @def PDM_NVMEM_NAME
@@ -24,6 +29,70 @@ enum pdm_nvmem_command {
 	PDM_NVMEM_CMD_INVALID	= 0xFF
 };
 
+/**
+ * @def PDM_NVMEM_XFER_CHUNK
+ * @brief Largest block moved through the bounce buffer per backend call
+ */
+#define PDM_NVMEM_XFER_CHUNK	(PAGE_SIZE)
+
+/**
+ * @def PDM_NVMEM_READAHEAD_MAX
+ * @brief Largest read-ahead window, the window is read with the client lock held
+ */
+#define PDM_NVMEM_READAHEAD_MAX	(64 * 1024)
+
+/**
+ * @struct pdm_nvmem_wb_stats
+ * @brief Write-back cache statistics, exported through debugfs
+ */
+struct pdm_nvmem_wb_stats {
+	u64 bytes_written;			/**< Bytes accepted into the cache */
+	u64 pages_dirtied;			/**< Clean pages that became dirty */
+	u64 page_loads;				/**< Pages read from the device for partial writes */
+	u64 flushes;				/**< Flush passes that found dirty pages */
+	u64 pages_flushed;			/**< Pages programmed to the device */
+	u64 flush_errors;			/**< Page programs that failed */
+	u64 ra_prefetches;			/**< Read-ahead windows filled */
+	u64 ra_hits;				/**< Reads served from the read-ahead window */
+};
+
+/**
+ * @struct pdm_nvmem_stream
+ * @brief Double-buffered state of the streaming reads of a client
+ *
+ * While one buffer is copied to the reader, the next chunk is read into the other one
+ * from a work item. The buffers are allocated once per client, reads take turns on them.
+ */
+struct pdm_nvmem_stream {
+	struct pdm_client *client;		/**< Client being read */
+	struct work_struct work;		/**< Read-ahead of the next chunk */
+	void *buf[2];				/**< Chunk buffers */
+	size_t chunk;				/**< Chunk size, a multiple of the page size */
+	loff_t ra_pos;				/**< Device offset of the read-ahead chunk */
+	size_t ra_len;				/**< Length of the read-ahead chunk */
+	unsigned int ra_idx;			/**< Buffer receiving the read-ahead chunk */
+	int ra_status;				/**< Result of the read-ahead */
+};
+
+/**
+ * @struct pdm_nvmem_record_store
+ * @brief Log-structured record store kept in two banks of an NVMEM region
+ *
+ * Records are appended to the active bank. When it is full the live records are copied to
+ * the other bank, which becomes active once its header is written.
+ */
+struct pdm_nvmem_record_store {
+	unsigned int base;			/**< Region start offset */
+	unsigned int bank_size;			/**< Size of each of the two banks */
+	unsigned int bank;			/**< Active bank, 0 or 1 */
+	u32 generation;				/**< Generation of the active bank */
+	unsigned int tail;			/**< Offset of the next record in the active bank */
+	struct xarray index;			/**< Key to offset of its latest record */
+	unsigned int live;			/**< Number of live keys */
+	u64 appends;				/**< Records written */
+	u64 compactions;			/**< Bank switches */
+};
+
 /**
  * @struct pdm_nvmem_priv
  * @brief PDM NVMEM Device Private Data Structure
@@ -32,13 +101,87 @@ enum pdm_nvmem_command {
  * operation functions.
  */
 struct pdm_nvmem_priv {
+	struct pdm_client *client;
+	struct mutex lock;			/**< Serializes transfers from all openers */
+	unsigned int size;			/**< Device size in bytes, from the DT "size" property */
+	unsigned int page_size;			/**< Physical page size from DT "pagesize", 0 if unknown */
+	unsigned int flush_delay_ms;		/**< Delay before dirty pages are flushed, 0 for fsync/close only */
+	u8 *wb_buf;				/**< Image of the pages held in the write-back cache */
+	unsigned long *wb_valid;		/**< Pages loaded into wb_buf */
+	unsigned long *wb_dirty;		/**< Pages modified since the last flush */
+	struct delayed_work flush_work;		/**< Delayed write-back flush */
+	void *ra_buf;				/**< Read-ahead window, NULL if disabled */
+	void *ra_fill;				/**< Spare window the prefetch builds the next window in */
+	unsigned int ra_gen;			/**< Bumped when prefetched bytes may have become stale */
+	unsigned int ra_size;			/**< Read-ahead window size */
+	unsigned int ra_start;			/**< Device offset of the window contents */
+	unsigned int ra_len;			/**< Valid bytes in the window */
+	bool ra_valid;				/**< Window holds current device contents */
+	unsigned int ra_next;			/**< Device offset the pending prefetch starts at */
+	struct work_struct ra_work;		/**< Asynchronous window prefetch */
+	struct mutex stream_lock;		/**< Serializes streaming reads on @stream */
+	struct pdm_nvmem_stream stream;		/**< Streaming read buffers */
+	struct pdm_nvmem_wb_stats stats;	/**< Write-back statistics */
+	struct dentry *debugfs;			/**< Statistics file */
+	void *shadow;				/**< Page-aligned image of the device, mmap()able */
+	bool shadow_loaded;			/**< Shadow holds the device contents */
+	struct nvmem_device *nvmem;		/**< Kernel nvmem provider, NULL if not registered */
+	void *hw_priv;				/**< Backend private data */
+	struct pdm_nvmem_record_store *records;	/**< Record store, NULL if not configured */
 	int (*read_reg)(struct pdm_client *client, unsigned int offset, void *val, size_t bytes);
 	int (*write_reg)(struct pdm_client *client, unsigned int offset, void *val, size_t bytes);
+	/* Optional: backend cache control */
+	int (*cache_sync)(struct pdm_client *client);
+	int (*cache_drop)(struct pdm_client *client);
 };
 
+/**
+ * @brief Reads a block through the write-back cache and the shadow image.
+ *
+ * Must be called with nvmem_priv->lock held.
+ */
+int pdm_nvmem_xfer_read(struct pdm_client *client, unsigned int offset, void *val, size_t bytes);
+
+/**
+ * @brief Writes a block through the write-back cache, keeping the shadow image coherent.
+ *
+ * Must be called with nvmem_priv->lock held.
+ */
+int pdm_nvmem_xfer_write(struct pdm_client *client, unsigned int offset, const void *val, size_t bytes);
+
+/**
+ * @brief Programs every dirty write-back page to the device.
+ *
+ * Must be called with nvmem_priv->lock held.
+ */
+int pdm_nvmem_wb_flush(struct pdm_client *client);
+
+/**
+ * @brief Sets up the record store when the DT node provides a "record-region" property.
+ *
+ * Must be called with nvmem_priv->lock held.
+ */
+int pdm_nvmem_record_init(struct pdm_client *client);
+
+/**
+ * @brief Releases the record store index.
+ */
+void pdm_nvmem_record_exit(struct pdm_client *client);
+
+/**
+ * @brief Looks up the latest value of a record. Must be called with nvmem_priv->lock held.
+ */
+int pdm_nvmem_record_get(struct pdm_client *client, struct pdm_nvmem_record *record);
+
+/**
+ * @brief Appends a new value of a record, @len 0 deletes it. Must be called with nvmem_priv->lock held.
+ */
+int pdm_nvmem_record_set(struct pdm_client *client, const struct pdm_nvmem_record *record);
+
 /**
  * @brief Match data structure for initializing PWM type DIMMER devices.
  */
 extern const struct pdm_client_match_data pdm_nvmem_spi_match_data;
+extern const struct pdm_client_match_data pdm_nvmem_i2c_match_data;
 
 #endif /* _PDM_NVMEM_PRIV_H_ */
@@ -0,0 +1,444 @@
+#include <linux/crc32.h>
+#include <linux/slab.h>
+
+#include "pdm.h"
+#include "pdm_nvmem_priv.h"
+
+#define PDM_NVMEM_RECORD_BANK_MAGIC	(0x524D4450)	/* "PDMR" */
+#define PDM_NVMEM_RECORD_MAGIC		(0x5244)	/* "DR" */
+#define PDM_NVMEM_RECORD_TOMBSTONE	BIT(0)		/* Record deletes its key */
+#define PDM_NVMEM_RECORD_KEY_MAX	(0xFFFF)
+
+/**
+ * @brief On-media bank header, written last when a bank becomes active.
+ */
+struct pdm_nvmem_bank_hdr {
+	__le32 magic;
+	__le32 generation;
+	__le32 crc;
+} __packed;
+
+/**
+ * @brief On-media record header, followed by @len data bytes.
+ *
+ * @gen is the low byte of the bank generation, records left over from an older use
+ * of the bank do not match and terminate the log.
+ */
+struct pdm_nvmem_record_hdr {
+	__le16 magic;
+	__le16 key;
+	u8 len;
+	u8 gen;
+	u8 flags;
+	u8 reserved;
+	__le32 crc;
+} __packed;
+
+#define PDM_NVMEM_RECORD_SIZE_MAX	(sizeof(struct pdm_nvmem_record_hdr) + PDM_NVMEM_RECORD_DATA_MAX)
+
+/**
+ * @brief Offset of the first record of a bank.
+ */
+static unsigned int pdm_nvmem_record_bank_start(struct pdm_nvmem_record_store *store, unsigned int bank)
+{
+	return store->base + bank * store->bank_size;
+}
+
+/**
+ * @brief CRC over the record header (without the CRC field) and its data.
+ */
+static u32 pdm_nvmem_record_crc(const struct pdm_nvmem_record_hdr *hdr, const void *data)
+{
+	u32 crc;
+
+	crc = crc32_le(~0, (const u8 *)hdr, offsetof(struct pdm_nvmem_record_hdr, crc));
+	return crc32_le(crc, data, hdr->len);
+}
+
+/**
+ * @brief Reads and validates the header of a bank.
+ *
+ * @return Returns 0 if the bank holds a valid header; negative error code otherwise.
+ */
+static int pdm_nvmem_record_read_bank(struct pdm_client *client, struct pdm_nvmem_record_store *store,
+				      unsigned int bank, u32 *generation)
+{
+	struct pdm_nvmem_bank_hdr hdr;
+	int status;
+
+	status = pdm_nvmem_xfer_read(client, pdm_nvmem_record_bank_start(store, bank), &hdr, sizeof(hdr));
+	if (status) {
+		return status;
+	}
+
+	if (le32_to_cpu(hdr.magic) != PDM_NVMEM_RECORD_BANK_MAGIC
+		|| le32_to_cpu(hdr.crc) != crc32_le(~0, (const u8 *)&hdr, offsetof(struct pdm_nvmem_bank_hdr, crc))) {
+		return -ENOENT;
+	}
+
+	*generation = le32_to_cpu(hdr.generation);
+	return 0;
+}
+
+/**
+ * @brief Writes the header that makes a bank active.
+ */
+static int pdm_nvmem_record_write_bank(struct pdm_client *client, struct pdm_nvmem_record_store *store,
+				       unsigned int bank, u32 generation)
+{
+	struct pdm_nvmem_bank_hdr hdr;
+
+	hdr.magic = cpu_to_le32(PDM_NVMEM_RECORD_BANK_MAGIC);
+	hdr.generation = cpu_to_le32(generation);
+	hdr.crc = cpu_to_le32(crc32_le(~0, (const u8 *)&hdr, offsetof(struct pdm_nvmem_bank_hdr, crc)));
+
+	return pdm_nvmem_xfer_write(client, pdm_nvmem_record_bank_start(store, bank), &hdr, sizeof(hdr));
+}
+
+/**
+ * @brief Reads and validates the record at @offset of @bank written in @generation.
+ *
+ * @return Returns 0 on success; -ENOENT at the end of the log; negative error code on failure.
+ */
+static int pdm_nvmem_record_read(struct pdm_client *client, struct pdm_nvmem_record_store *store,
+				 unsigned int bank, u32 generation, unsigned int offset,
+				 struct pdm_nvmem_record_hdr *hdr, void *data)
+{
+	unsigned int end = pdm_nvmem_record_bank_start(store, bank) + store->bank_size;
+	int status;
+
+	if (offset + sizeof(*hdr) > end) {
+		return -ENOENT;
+	}
+
+	status = pdm_nvmem_xfer_read(client, offset, hdr, sizeof(*hdr));
+	if (status) {
+		return status;
+	}
+
+	if (le16_to_cpu(hdr->magic) != PDM_NVMEM_RECORD_MAGIC || hdr->gen != (u8)generation
+		|| hdr->len > PDM_NVMEM_RECORD_DATA_MAX || offset + sizeof(*hdr) + hdr->len > end) {
+		return -ENOENT;
+	}
+
+	status = pdm_nvmem_xfer_read(client, offset + sizeof(*hdr), data, hdr->len);
+	if (status) {
+		return status;
+	}
+
+	/* A torn tail record fails the CRC and ends the log */
+	if (le32_to_cpu(hdr->crc) != pdm_nvmem_record_crc(hdr, data)) {
+		return -ENOENT;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Updates the index after a record of @key was written at @offset.
+ */
+static int pdm_nvmem_record_index(struct pdm_nvmem_record_store *store, unsigned int key, u8 flags,
+				  unsigned int offset)
+{
+	void *old;
+
+	if (flags & PDM_NVMEM_RECORD_TOMBSTONE) {
+		if (xa_erase(&store->index, key)) {
+			store->live--;
+		}
+		return 0;
+	}
+
+	old = xa_store(&store->index, key, xa_mk_value(offset), GFP_KERNEL);
+	if (xa_is_err(old)) {
+		return xa_err(old);
+	}
+	if (!old) {
+		store->live++;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Appends a record at the tail of the active bank.
+ */
+static int pdm_nvmem_record_append(struct pdm_client *client, struct pdm_nvmem_record_store *store,
+				   unsigned int key, u8 flags, const void *data, unsigned int len)
+{
+	u8 buf[PDM_NVMEM_RECORD_SIZE_MAX];
+	struct pdm_nvmem_record_hdr *hdr = (struct pdm_nvmem_record_hdr *)buf;
+	unsigned int size = sizeof(*hdr) + len;
+	unsigned int end = pdm_nvmem_record_bank_start(store, store->bank) + store->bank_size;
+	unsigned int offset = store->tail;
+	int status;
+
+	if (offset + size > end) {
+		return -ENOSPC;
+	}
+
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->magic = cpu_to_le16(PDM_NVMEM_RECORD_MAGIC);
+	hdr->key = cpu_to_le16(key);
+	hdr->len = len;
+	hdr->gen = (u8)store->generation;
+	hdr->flags = flags;
+	memcpy(buf + sizeof(*hdr), data, len);
+	hdr->crc = cpu_to_le32(pdm_nvmem_record_crc(hdr, buf + sizeof(*hdr)));
+
+	status = pdm_nvmem_xfer_write(client, offset, buf, size);
+	if (status) {
+		return status;
+	}
+
+	store->tail = offset + size;
+	store->appends++;
+	return pdm_nvmem_record_index(store, key, flags, offset);
+}
+
+/**
+ * @brief Rebuilds the index by scanning the active bank, formatting the region if empty.
+ */
+static int pdm_nvmem_record_scan(struct pdm_client *client, struct pdm_nvmem_record_store *store)
+{
+	u8 data[PDM_NVMEM_RECORD_DATA_MAX];
+	struct pdm_nvmem_record_hdr hdr;
+	u32 generation[2];
+	bool valid[2];
+	unsigned int bank;
+	unsigned int offset;
+	int status;
+
+	xa_destroy(&store->index);
+	store->live = 0;
+
+	for (bank = 0; bank < 2; bank++) {
+		valid[bank] = !pdm_nvmem_record_read_bank(client, store, bank, &generation[bank]);
+	}
+
+	if (!valid[0] && !valid[1]) {
+		OSA_INFO("No record store found, formatting\n");
+		store->bank = 0;
+		store->generation = 1;
+		store->tail = pdm_nvmem_record_bank_start(store, 0) + sizeof(struct pdm_nvmem_bank_hdr);
+		return pdm_nvmem_record_write_bank(client, store, 0, store->generation);
+	}
+
+	if (valid[0] && valid[1]) {
+		store->bank = ((s32)(generation[1] - generation[0]) > 0) ? 1 : 0;
+	} else {
+		store->bank = valid[1] ? 1 : 0;
+	}
+	store->generation = generation[store->bank];
+
+	offset = pdm_nvmem_record_bank_start(store, store->bank) + sizeof(struct pdm_nvmem_bank_hdr);
+	while (!(status = pdm_nvmem_record_read(client, store, store->bank, store->generation, offset, &hdr, data))) {
+		status = pdm_nvmem_record_index(store, le16_to_cpu(hdr.key), hdr.flags, offset);
+		if (status) {
+			return status;
+		}
+		offset += sizeof(hdr) + hdr.len;
+	}
+	if (status != -ENOENT) {
+		return status;
+	}
+
+	store->tail = offset;
+	return 0;
+}
+
+/**
+ * @brief Copies the live records into the other bank and switches to it.
+ *
+ * The new bank only becomes active once its header is written after all records, an
+ * interrupted compaction leaves the old bank in use.
+ */
+static int pdm_nvmem_record_compact(struct pdm_client *client, struct pdm_nvmem_record_store *store)
+{
+	u8 data[PDM_NVMEM_RECORD_DATA_MAX];
+	struct pdm_nvmem_record_hdr hdr;
+	unsigned int old_bank = store->bank;
+	u32 old_generation = store->generation;
+	unsigned long key;
+	void *entry;
+	int status = 0;
+
+	store->bank = !old_bank;
+	store->generation = old_generation + 1;
+	store->tail = pdm_nvmem_record_bank_start(store, store->bank) + sizeof(struct pdm_nvmem_bank_hdr);
+
+	xa_for_each(&store->index, key, entry) {
+		status = pdm_nvmem_record_read(client, store, old_bank, old_generation, xa_to_value(entry), &hdr, data);
+		if (status) {
+			break;
+		}
+
+		status = pdm_nvmem_record_append(client, store, key, 0, data, hdr.len);
+		if (status) {
+			break;
+		}
+	}
+
+	/* The write-back cache flushes in offset order, force the records out before the header */
+	if (!status) {
+		status = pdm_nvmem_wb_flush(client);
+	}
+	if (!status) {
+		status = pdm_nvmem_record_write_bank(client, store, store->bank, store->generation);
+	}
+
+	if (status) {
+		OSA_ERROR("Record store compaction failed, status: %d\n", status);
+		pdm_nvmem_record_scan(client, store);
+		return status;
+	}
+
+	store->compactions++;
+	OSA_DEBUG("Record store compacted to bank %u, %u live records\n", store->bank, store->live);
+	return 0;
+}
+
+/**
+ * @brief Looks up the latest value of a record.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param record Record with @key set, @len and @data are filled in.
+ * @return Returns 0 on success; -ENOENT if the key has no value; negative error code on failure.
+ */
+int pdm_nvmem_record_get(struct pdm_client *client, struct pdm_nvmem_record *record)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_record_store *store = nvmem_priv->records;
+	struct pdm_nvmem_record_hdr hdr;
+	void *entry;
+	int status;
+
+	if (!store) {
+		return -ENOTSUPP;
+	}
+
+	if (record->key > PDM_NVMEM_RECORD_KEY_MAX) {
+		return -EINVAL;
+	}
+
+	entry = xa_load(&store->index, record->key);
+	if (!entry) {
+		return -ENOENT;
+	}
+
+	status = pdm_nvmem_record_read(client, store, store->bank, store->generation, xa_to_value(entry),
+				       &hdr, record->data);
+	if (status) {
+		OSA_ERROR("Record %u is corrupted, status: %d\n", record->key, status);
+		return status == -ENOENT ? -EIO : status;
+	}
+
+	record->len = hdr.len;
+	return 0;
+}
+
+/**
+ * @brief Appends a new value of a record, compacting the store when the active bank is full.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param record Record to store, @len 0 deletes the key.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+int pdm_nvmem_record_set(struct pdm_client *client, const struct pdm_nvmem_record *record)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_record_store *store = nvmem_priv->records;
+	u8 flags = record->len ? 0 : PDM_NVMEM_RECORD_TOMBSTONE;
+	int status;
+
+	if (!store) {
+		return -ENOTSUPP;
+	}
+
+	if (record->key > PDM_NVMEM_RECORD_KEY_MAX || record->len > PDM_NVMEM_RECORD_DATA_MAX) {
+		return -EINVAL;
+	}
+
+	if (!record->len && !xa_load(&store->index, record->key)) {
+		return 0;
+	}
+
+	status = pdm_nvmem_record_append(client, store, record->key, flags, record->data, record->len);
+	if (status != -ENOSPC) {
+		return status;
+	}
+
+	status = pdm_nvmem_record_compact(client, store);
+	if (status) {
+		return status;
+	}
+
+	return pdm_nvmem_record_append(client, store, record->key, flags, record->data, record->len);
+}
+
+/**
+ * @brief Sets up the record store when the DT node provides a "record-region" property.
+ *
+ * "record-region = <offset size>" selects the region, split into two equal banks.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+int pdm_nvmem_record_init(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct device_node *np = pdm_client_get_of_node(client);
+	struct pdm_nvmem_record_store *store;
+	u32 region[2];
+	int status;
+
+	if (!np || of_property_read_u32_array(np, "record-region", region, ARRAY_SIZE(region))) {
+		return 0;
+	}
+
+	if (!nvmem_priv->read_reg || !nvmem_priv->write_reg || region[0] >= nvmem_priv->size
+		|| region[1] > nvmem_priv->size - region[0]
+		|| region[1] / 2 < sizeof(struct pdm_nvmem_bank_hdr) + 2 * PDM_NVMEM_RECORD_SIZE_MAX) {
+		OSA_ERROR("Invalid record-region <0x%x 0x%x>\n", region[0], region[1]);
+		return -EINVAL;
+	}
+
+	store = kzalloc(sizeof(*store), GFP_KERNEL);
+	if (!store) {
+		return -ENOMEM;
+	}
+
+	store->base = region[0];
+	store->bank_size = region[1] / 2;
+	xa_init(&store->index);
+
+	status = pdm_nvmem_record_scan(client, store);
+	if (status) {
+		OSA_ERROR("Failed to load record store, status: %d\n", status);
+		xa_destroy(&store->index);
+		kfree(store);
+		return status;
+	}
+
+	nvmem_priv->records = store;
+	OSA_DEBUG("Record store: bank %u, generation %u, %u live records, %u bytes used\n",
+		  store->bank, store->generation, store->live,
+		  store->tail - pdm_nvmem_record_bank_start(store, store->bank));
+	return 0;
+}
+
+/**
+ * @brief Releases the record store index.
+ *
+ * @param client Pointer to the PDM client structure.
+ */
+void pdm_nvmem_record_exit(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+
+	if (nvmem_priv->records) {
+		xa_destroy(&nvmem_priv->records->index);
+		kfree(nvmem_priv->records);
+		nvmem_priv->records = NULL;
+	}
+}
@@ -1,36 +1,229 @@
 #include <linux/spi/spi.h>
 #include <linux/regmap.h>
+#include <linux/completion.h>
 
 #include "pdm.h"
 #include "pdm_nvmem_priv.h"
 
+/**
+ * @brief Cache type used for read-mostly parts, maple tree cache is available since 6.4.
+ */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 4, 0)
+#define PDM_NVMEM_SPI_REGCACHE		REGCACHE_RBTREE
+#else
+#define PDM_NVMEM_SPI_REGCACHE		REGCACHE_MAPLE
+#endif
 
-static int pdm_nvmem_regmap_spi_read_reg(struct pdm_client *client, unsigned int offset, void *val, size_t bytes)
+#define PDM_NVMEM_SPI_REG_BITS		(8)	/* Default address width */
+#define PDM_NVMEM_SPI_CHUNK_SIZE	(256)	/* Bytes read by one pipelined message */
+#define PDM_NVMEM_SPI_SLOTS		(4)	/* Messages kept in flight */
+
+/**
+ * @brief One in-flight read message with its preallocated DMA-safe buffers.
+ */
+struct pdm_nvmem_spi_slot {
+	struct spi_message msg;
+	struct spi_transfer xfers[2];
+	struct completion done;
+	u8 *tx;				/* Command and address bytes */
+	u8 *rx;				/* Chunk data */
+	size_t len;			/* Bytes requested by the current message */
+};
+
+/**
+ * @brief SPI NVMEM driver private data.
+ */
+struct pdm_nvmem_spi_data {
+	unsigned int addr_bytes;	/* Address bytes, regmap big endian format */
+	u8 read_flag;			/* OR'ed into the first address byte on reads */
+	size_t chunk_size;		/* Payload of one pipelined message */
+	struct pdm_nvmem_spi_slot slots[PDM_NVMEM_SPI_SLOTS];
+};
+
+static void pdm_nvmem_spi_slot_complete(void *context)
 {
-	struct spi_transfer t[2];
-	struct spi_message  m;
-	unsigned char cmd = PDM_NVMEM_CMD_READ_REG;
-	char *buf = val;
-	int status;
+	struct pdm_nvmem_spi_slot *slot = context;
 
-	spi_message_init(&m);
-	memset(t, 0, sizeof(t));
+	complete(&slot->done);
+}
 
-	t[0].tx_buf = &cmd;
-	t[0].len = 1;
-	spi_message_add_tail(&t[0], &m);
+/**
+ * @brief Queues the read of one chunk on @slot without waiting for it.
+ */
+static int pdm_nvmem_spi_slot_submit(struct pdm_client *client, struct pdm_nvmem_spi_data *spi_data,
+				     struct pdm_nvmem_spi_slot *slot, unsigned int offset, size_t len)
+{
+	unsigned int i;
 
-	t[1].rx_buf = buf;
-	t[1].len = 1;
-	spi_message_add_tail(&t[1], &m);
+	for (i = 0; i < spi_data->addr_bytes; i++) {
+		slot->tx[i] = (offset >> (8 * (spi_data->addr_bytes - 1 - i))) & 0xFF;
+	}
+	slot->tx[0] |= spi_data->read_flag;
+	slot->len = len;
 
-	status = spi_sync(client->hardware.spi.spidev, &m);
+	memset(slot->xfers, 0, sizeof(slot->xfers));
+	slot->xfers[0].tx_buf = slot->tx;
+	slot->xfers[0].len = spi_data->addr_bytes;
+	slot->xfers[1].rx_buf = slot->rx;
+	slot->xfers[1].len = len;
 
-	return 0;
+	spi_message_init(&slot->msg);
+	spi_message_add_tail(&slot->xfers[0], &slot->msg);
+	spi_message_add_tail(&slot->xfers[1], &slot->msg);
+	slot->msg.complete = pdm_nvmem_spi_slot_complete;
+	slot->msg.context = slot;
+
+	reinit_completion(&slot->done);
+	return spi_async(client->hardware.spi.spidev, &slot->msg);
+}
+
+/**
+ * @brief Reads a large block as a pipeline of asynchronous chunk reads.
+ *
+ * Up to PDM_NVMEM_SPI_SLOTS messages are queued at once so the controller moves on to the
+ * next chunk while the previous one is copied out. After an error no further chunks are
+ * queued, but every message already in flight is waited for before returning.
+ */
+static int pdm_nvmem_spi_pipelined_read(struct pdm_client *client, unsigned int offset, void *val, size_t bytes)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_spi_data *spi_data = nvmem_priv->hw_priv;
+	struct pdm_nvmem_spi_slot *slot;
+	size_t chunks = DIV_ROUND_UP(bytes, spi_data->chunk_size);
+	size_t submitted = 0;
+	size_t pos;
+	size_t i;
+	int status = 0;
+
+	while (submitted < chunks && submitted < PDM_NVMEM_SPI_SLOTS) {
+		pos = submitted * spi_data->chunk_size;
+		status = pdm_nvmem_spi_slot_submit(client, spi_data, &spi_data->slots[submitted], offset + pos,
+						   min_t(size_t, bytes - pos, spi_data->chunk_size));
+		if (status) {
+			break;
+		}
+		submitted++;
+	}
+
+	for (i = 0; i < submitted; i++) {
+		slot = &spi_data->slots[i % PDM_NVMEM_SPI_SLOTS];
+		wait_for_completion(&slot->done);
+
+		if (!status) {
+			status = slot->msg.status;
+		}
+		if (status) {
+			continue;
+		}
+		memcpy(val + i * spi_data->chunk_size, slot->rx, slot->len);
+
+		if (submitted < chunks) {
+			pos = submitted * spi_data->chunk_size;
+			status = pdm_nvmem_spi_slot_submit(client, spi_data, slot, offset + pos,
+							   min_t(size_t, bytes - pos, spi_data->chunk_size));
+			if (!status) {
+				submitted++;
+			}
+		}
+	}
+
+	if (status) {
+		OSA_ERROR("Pipelined read at 0x%x failed, status: %d\n", offset, status);
+	}
+
+	return status;
+}
+
+/**
+ * @brief Reads a block through the regmap.
+ *
+ * Cached reads are served from the cache, which is filled from the device when the regmap is
+ * created, so only bytes dropped since then are fetched again.
+ * Uncached reads larger than one chunk are pipelined, smaller ones go out as a single raw
+ * transfer.
+ */
+static int pdm_nvmem_regmap_spi_read_reg(struct pdm_client *client, unsigned int offset, void *val, size_t bytes)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_spi_data *spi_data = nvmem_priv->hw_priv;
+
+	if (nvmem_priv->cache_sync) {
+		return regmap_bulk_read(client->map, offset, val, bytes);
+	}
+
+	if (spi_data && bytes > spi_data->chunk_size) {
+		return pdm_nvmem_spi_pipelined_read(client, offset, val, bytes);
+	}
+
+	return regmap_raw_read(client->map, offset, val, bytes);
 }
 
+/**
+ * @brief Writes a block through the regmap, keeping the cache coherent.
+ */
 static int pdm_nvmem_regmap_spi_write_reg(struct pdm_client *client, unsigned int offset, void *val, size_t bytes)
 {
+	return regmap_bulk_write(client->map, offset, val, bytes);
+}
+
+/**
+ * @brief Writes dirty cached bytes back to the device.
+ */
+static int pdm_nvmem_regmap_spi_cache_sync(struct pdm_client *client)
+{
+	return regcache_sync(client->map);
+}
+
+/**
+ * @brief Discards the whole cache so the next reads hit the device.
+ */
+static int pdm_nvmem_regmap_spi_cache_drop(struct pdm_client *client)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+
+	return regcache_drop_region(client->map, 0, nvmem_priv->size - 1);
+}
+
+/**
+ * @brief Allocates the pipelined read slots.
+ *
+ * Only byte aligned addresses are supported, other layouts keep using the regmap alone.
+ */
+static int pdm_nvmem_spi_pipeline_init(struct pdm_client *client, const struct regmap_config *regmap_config)
+{
+	struct pdm_nvmem_priv *nvmem_priv = pdm_client_get_private_data(client);
+	struct pdm_nvmem_spi_data *spi_data;
+	struct pdm_nvmem_spi_slot *slot;
+	unsigned int i;
+
+	if (regmap_config->reg_bits % 8 || regmap_config->reg_bits > 32) {
+		OSA_DEBUG("reg-bits %d not byte aligned, pipelined reads disabled\n", regmap_config->reg_bits);
+		return 0;
+	}
+
+	spi_data = devm_kzalloc(&client->pdmdev->dev, sizeof(*spi_data), GFP_KERNEL);
+	if (!spi_data) {
+		OSA_ERROR("Failed to allocate SPI NVMEM data\n");
+		return -ENOMEM;
+	}
+
+	spi_data->addr_bytes = regmap_config->reg_bits / 8;
+	spi_data->read_flag = regmap_config->read_flag_mask;
+	spi_data->chunk_size = min_t(size_t, PDM_NVMEM_SPI_CHUNK_SIZE,
+				     spi_max_transfer_size(client->hardware.spi.spidev));
+
+	for (i = 0; i < PDM_NVMEM_SPI_SLOTS; i++) {
+		slot = &spi_data->slots[i];
+		slot->tx = devm_kzalloc(&client->pdmdev->dev, spi_data->addr_bytes, GFP_KERNEL);
+		slot->rx = devm_kzalloc(&client->pdmdev->dev, spi_data->chunk_size, GFP_KERNEL);
+		if (!slot->tx || !slot->rx) {
+			OSA_ERROR("Failed to allocate pipelined read buffers\n");
+			return -ENOMEM;
+		}
+		init_completion(&slot->done);
+	}
+
+	nvmem_priv->hw_priv = spi_data;
 	return 0;
 }
 
@@ -38,7 +231,10 @@ static int pdm_nvmem_regmap_spi_init(struct pdm_client *client)
 {
 	struct pdm_nvmem_priv *nvmem_priv;
 	struct regmap_config regmap_config;
+	struct device_node *np;
 	struct regmap *regmap;
+	unsigned int value;
+	int status;
 
 	nvmem_priv = pdm_client_get_private_data(client);
 	if (!nvmem_priv) {
@@ -46,19 +242,60 @@ static int pdm_nvmem_regmap_spi_init(struct pdm_client *client)
 		return -ENOMEM;
 	}
 
-	nvmem_priv->read_reg = pdm_nvmem_regmap_spi_read_reg;
-	nvmem_priv->write_reg = pdm_nvmem_regmap_spi_write_reg;
+	np = pdm_client_get_of_node(client);
 
 	memset(&regmap_config, 0, sizeof(regmap_config));
 	regmap_config.val_bits = 8;
-	regmap_config.reg_bits = 8;
+	regmap_config.reg_bits = PDM_NVMEM_SPI_REG_BITS;
+	if (!of_property_read_u32(np, "reg-bits", &value)) {
+		regmap_config.reg_bits = value;
+	}
+	if (!of_property_read_u32(np, "read-flag-mask", &value)) {
+		regmap_config.read_flag_mask = value;
+	}
+	if (nvmem_priv->size) {
+		/* Wider parts would wrap the address and hit the wrong bytes */
+		if (regmap_config.reg_bits < 32 && nvmem_priv->size > BIT(regmap_config.reg_bits)) {
+			OSA_ERROR("size %u does not fit in %d address bits\n", nvmem_priv->size,
+				  regmap_config.reg_bits);
+			return -EINVAL;
+		}
+		regmap_config.max_register = nvmem_priv->size - 1;
+	}
+	/* Transfers are serialized by nvmem_priv->lock */
 	regmap_config.disable_locking = true;
 
+	if (of_property_read_bool(np, "regmap-cache")) {
+		if (nvmem_priv->size) {
+			regmap_config.cache_type = PDM_NVMEM_SPI_REGCACHE;
+			/* The cache is filled by one raw read at init instead of one read per byte */
+			regmap_config.num_reg_defaults_raw = nvmem_priv->size;
+		} else {
+			OSA_WARN("regmap-cache requires the size property, cache disabled\n");
+		}
+	}
+
 	regmap = devm_regmap_init_spi(client->hardware.spi.spidev, &regmap_config);
 	if (IS_ERR(regmap)) {
+		OSA_ERROR("Failed to init regmap: %ld\n", PTR_ERR(regmap));
 		return PTR_ERR(regmap);
 	}
 
+	if (regmap_config.cache_type == REGCACHE_NONE) {
+		status = pdm_nvmem_spi_pipeline_init(client, &regmap_config);
+		if (status) {
+			return status;
+		}
+	}
+
+	client->map = regmap;
+	nvmem_priv->read_reg = pdm_nvmem_regmap_spi_read_reg;
+	nvmem_priv->write_reg = pdm_nvmem_regmap_spi_write_reg;
+	if (regmap_config.cache_type != REGCACHE_NONE) {
+		nvmem_priv->cache_sync = pdm_nvmem_regmap_spi_cache_sync;
+		nvmem_priv->cache_drop = pdm_nvmem_regmap_spi_cache_drop;
+	}
+
 	return 0;
 }
 
@@ -77,6 +314,7 @@ static int pdm_nvmem_spi_setup(struct pdm_client *client)
 
 	if (!client) {
 		OSA_ERROR("Invalid client\n");
+		return -EINVAL;
 	}
 
 	np = pdm_client_get_of_node(client);
@@ -85,8 +323,9 @@ static int pdm_nvmem_spi_setup(struct pdm_client *client)
 		return -EINVAL;
 	}
 
+	client->hardware.spi.spidev = to_spi_device(client->pdmdev->dev.parent);
+
 	if (of_get_property(np, "enable-regmap", NULL)) {
-		OSA_INFO("No default-state property found, using defaults as off\n");
 		status = pdm_nvmem_regmap_spi_init(client);
 		if (status) {
 			OSA_ERROR("pdm_nvmem_regmap_spi_init failed, status: %d\n", status);
@@ -6,13 +6,15 @@
 static struct pdm_adapter *sensor_adapter = NULL;
 
 /**
- * @brief Sets the state of a specified PDM SENSOR device.
+ * @brief Reads one sample of a specified PDM SENSOR device.
  *
  * @param client Pointer to the PDM client structure.
- * @param state State value (0 or 1).
+ * @param type Sensor channel.
+ * @param val Sample value.
+ * @param timestamp CLOCK_BOOTTIME ns at which the sample was taken.
  * @return Returns 0 on success; negative error code on failure.
  */
-static int pdm_sensor_read_data(struct pdm_client *client, unsigned int type, unsigned int *val)
+static int pdm_sensor_read_data(struct pdm_client *client, unsigned int type, unsigned int *val, u64 *timestamp)
 {
 	struct pdm_sensor_priv *sensor_priv;
 	int status = 0;
@@ -33,12 +35,350 @@ static int pdm_sensor_read_data(struct pdm_client *client, unsigned int type, un
 		return -ENOTSUPP;
 	}
 
-	status = sensor_priv->read(client, type, val);
+	*timestamp = 0;
+	status = sensor_priv->read(client, type, val, timestamp);
 	if (status) {
-		OSA_ERROR("PDM SENSOR read_reg failed, status: %d\n", status);
+		/* Not an error, the channel is just not measured in the current mode */
+		if (status != -ENODATA) {
+			OSA_ERROR("PDM SENSOR read_reg failed, status: %d\n", status);
+		}
 		return status;
 	}
 
+	if (!*timestamp) {
+		*timestamp = ktime_get_boottime_ns();
+	}
+
+	if (type < PDM_SENSOR_CHANNEL_MAX && sensor_priv->thresholds[type].enable
+		&& !sensor_priv->thresholds[type].hardware) {
+		pdm_sensor_threshold_report(client, type, *val, *timestamp);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Computes the band a sample falls into, applying hysteresis on band exit.
+ */
+static enum pdm_sensor_threshold_zone pdm_sensor_threshold_zone(const struct pdm_sensor_threshold_state *state,
+								 unsigned int value)
+{
+	if (state->zone == PDM_SENSOR_ZONE_ABOVE && value + state->hysteresis >= state->high) {
+		return PDM_SENSOR_ZONE_ABOVE;
+	}
+	if (state->zone == PDM_SENSOR_ZONE_BELOW && value <= state->low + state->hysteresis) {
+		return PDM_SENSOR_ZONE_BELOW;
+	}
+	if (value > state->high) {
+		return PDM_SENSOR_ZONE_ABOVE;
+	}
+	if (value < state->low) {
+		return PDM_SENSOR_ZONE_BELOW;
+	}
+	return PDM_SENSOR_ZONE_INSIDE;
+}
+
+/**
+ * @brief Programs the hardware window that keeps the chip quiet while the channel stays in its band.
+ */
+static int pdm_sensor_threshold_program(struct pdm_client *client, unsigned int type,
+					const struct pdm_sensor_threshold_state *state)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	unsigned int low, high;
+
+	switch (state->zone) {
+	case PDM_SENSOR_ZONE_ABOVE:
+		low = state->high > state->hysteresis ? state->high - state->hysteresis : 0;
+		high = UINT_MAX;
+		break;
+	case PDM_SENSOR_ZONE_BELOW:
+		low = 0;
+		high = state->low + state->hysteresis;
+		break;
+	default:
+		low = state->low;
+		high = state->high;
+		break;
+	}
+
+	return sensor_priv->set_window(client, type, low, high);
+}
+
+/**
+ * @brief Enables client events while any event source is armed.
+ *
+ * Must be called with sensor_priv->lock held.
+ */
+static void pdm_sensor_update_events(struct pdm_sensor_priv *sensor_priv)
+{
+	bool armed = sensor_priv->wom_enabled;
+	bool polled = false;
+	int i;
+
+	for (i = 0; i < PDM_SENSOR_CHANNEL_MAX; i++) {
+		if (sensor_priv->thresholds[i].enable) {
+			armed = true;
+			if (!sensor_priv->thresholds[i].hardware) {
+				polled = true;
+			}
+		}
+	}
+
+	if (armed != pdm_client_event_enabled(sensor_priv->client)) {
+		pdm_client_event_enable(sensor_priv->client, armed);
+	}
+
+	if (polled) {
+		schedule_delayed_work(&sensor_priv->poll_work, msecs_to_jiffies(sensor_priv->poll_interval_ms));
+	} else {
+		cancel_delayed_work(&sensor_priv->poll_work);
+	}
+}
+
+/**
+ * @brief Feeds a fresh sample into the threshold evaluator.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param type Sensor channel.
+ * @param value Sample value.
+ * @param timestamp CLOCK_BOOTTIME ns at which the sample was taken.
+ */
+void pdm_sensor_threshold_report(struct pdm_client *client, unsigned int type, unsigned int value, u64 timestamp)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_threshold_state *state;
+	struct pdm_client_event event;
+	enum pdm_sensor_threshold_zone zone;
+
+	if (!sensor_priv || type >= PDM_SENSOR_CHANNEL_MAX) {
+		return;
+	}
+
+	state = &sensor_priv->thresholds[type];
+
+	mutex_lock(&sensor_priv->lock);
+	if (!state->enable) {
+		goto unlock;
+	}
+
+	zone = pdm_sensor_threshold_zone(state, value);
+	if (zone == state->zone) {
+		goto unlock;
+	}
+	state->zone = zone;
+
+	if (state->hardware && pdm_sensor_threshold_program(client, type, state)) {
+		OSA_WARN("Failed to reprogram threshold window of channel %u\n", type);
+	}
+
+	memset(&event, 0, sizeof(event));
+	event.type = PDM_CLIENT_EVENT_THRESHOLD;
+	event.channel = type;
+	event.code = zone;
+	event.value = value;
+	event.timestamp = timestamp;
+	pdm_client_event_push(client, &event);
+
+unlock:
+	mutex_unlock(&sensor_priv->lock);
+}
+
+/**
+ * @brief Arms or disarms the threshold of one sensor channel.
+ *
+ * The hardware window is used when the driver provides one for the channel, otherwise
+ * the channel is sampled periodically by the polling work.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param threshold Threshold configuration.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_sensor_set_threshold(struct pdm_client *client, const struct pdm_sensor_threshold *threshold)
+{
+	struct pdm_sensor_priv *sensor_priv;
+	struct pdm_sensor_threshold_state *state;
+	unsigned int value = 0;
+	u64 timestamp = 0;
+	bool was_hardware;
+	int status = 0;
+
+	sensor_priv = pdm_client_get_private_data(client);
+	if (!sensor_priv) {
+		OSA_ERROR("Get PDM Client Device Data Failed\n");
+		return -ENOMEM;
+	}
+
+	if (threshold->type == PDM_SENSOR_TYPE_NULL || threshold->type >= PDM_SENSOR_CHANNEL_MAX) {
+		OSA_ERROR("Invalid sensor type: %u\n", threshold->type);
+		return -EINVAL;
+	}
+
+	if (threshold->enable && threshold->low > threshold->high) {
+		OSA_ERROR("Invalid threshold band [%u, %u]\n", threshold->low, threshold->high);
+		return -EINVAL;
+	}
+
+	/* A trial read rejects channels the sensor does not have, -ENODATA only means not measured now */
+	if (threshold->enable) {
+		if (!sensor_priv->read) {
+			OSA_ERROR("read not supported\n");
+			return -ENOTSUPP;
+		}
+		status = sensor_priv->read(client, threshold->type, &value, &timestamp);
+		if (status && status != -ENODATA) {
+			OSA_ERROR("Channel %u cannot be read, status: %d\n", threshold->type, status);
+			return status;
+		}
+		status = 0;
+	}
+
+	state = &sensor_priv->thresholds[threshold->type];
+
+	mutex_lock(&sensor_priv->lock);
+	was_hardware = state->enable && state->hardware;
+
+	state->enable = !!threshold->enable;
+	state->hardware = false;
+	state->low = threshold->low;
+	state->high = threshold->high;
+	state->hysteresis = threshold->hysteresis;
+	state->zone = PDM_SENSOR_ZONE_INSIDE;
+
+	if (state->enable && sensor_priv->set_window) {
+		status = pdm_sensor_threshold_program(client, threshold->type, state);
+		if (!status) {
+			state->hardware = true;
+		} else if (status == -EOPNOTSUPP) {
+			status = 0;
+		} else {
+			OSA_ERROR("Failed to program threshold window, status: %d\n", status);
+			state->enable = false;
+		}
+	} else if (was_hardware) {
+		sensor_priv->set_window(client, threshold->type, 0, UINT_MAX);
+	}
+
+	pdm_sensor_update_events(sensor_priv);
+	mutex_unlock(&sensor_priv->lock);
+
+	OSA_DEBUG("Threshold of channel %u %s (%s)\n", threshold->type,
+		  state->enable ? "armed" : "disarmed", state->hardware ? "hardware" : "software");
+	return status;
+}
+
+/**
+ * @brief Enters or leaves the wake-on-motion mode of the sensor.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param config Wake-on-motion configuration.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_sensor_set_wom(struct pdm_client *client, const struct pdm_sensor_wom_config *config)
+{
+	struct pdm_sensor_priv *sensor_priv;
+	int status;
+
+	sensor_priv = pdm_client_get_private_data(client);
+	if (!sensor_priv) {
+		OSA_ERROR("Get PDM Client Device Data Failed\n");
+		return -ENOMEM;
+	}
+
+	if (!sensor_priv->set_wom) {
+		OSA_ERROR("set_wom not supported\n");
+		return -ENOTSUPP;
+	}
+
+	mutex_lock(&sensor_priv->lock);
+	status = sensor_priv->set_wom(client, config);
+	if (status) {
+		OSA_ERROR("PDM SENSOR set_wom failed, status: %d\n", status);
+	} else {
+		sensor_priv->wom_enabled = !!config->enable;
+		pdm_sensor_update_events(sensor_priv);
+	}
+	mutex_unlock(&sensor_priv->lock);
+
+	return status;
+}
+
+/**
+ * @brief Samples every software-evaluated threshold channel.
+ */
+static void pdm_sensor_poll_work_func(struct work_struct *work)
+{
+	struct pdm_sensor_priv *sensor_priv = container_of(to_delayed_work(work), struct pdm_sensor_priv, poll_work);
+	bool rearm = false;
+	unsigned int value = 0;
+	unsigned int type;
+	u64 timestamp;
+	int status;
+
+	for (type = 0; type < PDM_SENSOR_CHANNEL_MAX; type++) {
+		if (!sensor_priv->thresholds[type].enable || sensor_priv->thresholds[type].hardware) {
+			continue;
+		}
+		rearm = true;
+		status = pdm_sensor_read_data(sensor_priv->client, type, &value, &timestamp);
+		if (status == -ENODATA) {
+			if (!sensor_priv->thresholds[type].unmeasured) {
+				OSA_WARN("Threshold channel %u is not measured in the current mode, skipped\n", type);
+			}
+			sensor_priv->thresholds[type].unmeasured = true;
+		}
+		else if (!status) {
+			sensor_priv->thresholds[type].unmeasured = false;
+		}
+	}
+
+	if (rearm) {
+		schedule_delayed_work(&sensor_priv->poll_work, msecs_to_jiffies(sensor_priv->poll_interval_ms));
+	}
+}
+
+/**
+ * @brief Samples a group of sensor channels back-to-back.
+ *
+ * The clients are resolved first so that the reads are issued without any lookup in
+ * between. The client list lock is held throughout, keeping the clients registered.
+ *
+ * @param group Group description, values, timestamps and per-entry status are filled in.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_sensor_group_trigger(struct pdm_sensor_group_trigger *group)
+{
+	struct pdm_client *clients[PDM_SENSOR_GROUP_MAX];
+	struct pdm_client *client;
+	unsigned int i;
+
+	if (!group->count || group->count > PDM_SENSOR_GROUP_MAX) {
+		OSA_ERROR("Invalid group size: %u\n", group->count);
+		return -EINVAL;
+	}
+
+	mutex_lock(&sensor_adapter->client_list_mutex_lock);
+	for (i = 0; i < group->count; i++) {
+		clients[i] = NULL;
+		list_for_each_entry(client, &sensor_adapter->client_list, entry) {
+			if (client->index == group->entries[i].index) {
+				clients[i] = client;
+				break;
+			}
+		}
+	}
+
+	for (i = 0; i < group->count; i++) {
+		if (!clients[i]) {
+			group->entries[i].status = -ENODEV;
+			continue;
+		}
+		group->entries[i].status = pdm_sensor_read_data(clients[i], group->entries[i].type,
+								&group->entries[i].value,
+								&group->entries[i].timestamp);
+	}
+	mutex_unlock(&sensor_adapter->client_list_mutex_lock);
+
 	return 0;
 }
 
@@ -56,6 +396,14 @@ static long pdm_sensor_ioctl(struct file *filp, unsigned int cmd, unsigned long
 	int status = 0;
 	struct pdm_sensor_ioctl_data __user *user_data = (struct pdm_sensor_ioctl_data __user *)arg;
 	struct pdm_sensor_ioctl_data data;
+	struct pdm_sensor_threshold threshold;
+	struct pdm_sensor_wom_config wom;
+	struct pdm_sensor_imu_config imu_config;
+	struct pdm_sensor_priv *sensor_priv;
+	struct pdm_sensor_sample sample;
+	struct pdm_sensor_group_trigger *group;
+	unsigned int mode;
+	u64 timestamp;
 
 	if (!client) {
 		OSA_ERROR("Invalid client\n");
@@ -72,7 +420,7 @@ static long pdm_sensor_ioctl(struct file *filp, unsigned int cmd, unsigned long
 		}
 
 		// Perform the read operation
-		status = pdm_sensor_read_data(client, data.type, &data.value);
+		status = pdm_sensor_read_data(client, data.type, &data.value, &timestamp);
 		if (status) {
 			OSA_ERROR("Failed to read sensor register: %d\n", status);
 			return status;
@@ -85,6 +433,167 @@ static long pdm_sensor_ioctl(struct file *filp, unsigned int cmd, unsigned long
 		}
 		break;
 	}
+	case PDM_SENSOR_SET_THRESHOLD:
+	{
+		if (copy_from_user(&threshold, (void __user *)arg, sizeof(threshold))) {
+			OSA_ERROR("Failed to copy data from user space\n");
+			return -EFAULT;
+		}
+
+		status = pdm_sensor_set_threshold(client, &threshold);
+		break;
+	}
+	case PDM_SENSOR_GET_THRESHOLD:
+	{
+		if (copy_from_user(&threshold, (void __user *)arg, sizeof(threshold))) {
+			OSA_ERROR("Failed to copy data from user space\n");
+			return -EFAULT;
+		}
+
+		if (threshold.type >= PDM_SENSOR_CHANNEL_MAX) {
+			OSA_ERROR("Invalid sensor type: %u\n", threshold.type);
+			return -EINVAL;
+		}
+
+		sensor_priv = pdm_client_get_private_data(client);
+		mutex_lock(&sensor_priv->lock);
+		threshold.enable = sensor_priv->thresholds[threshold.type].enable;
+		threshold.low = sensor_priv->thresholds[threshold.type].low;
+		threshold.high = sensor_priv->thresholds[threshold.type].high;
+		threshold.hysteresis = sensor_priv->thresholds[threshold.type].hysteresis;
+		mutex_unlock(&sensor_priv->lock);
+
+		if (copy_to_user((void __user *)arg, &threshold, sizeof(threshold))) {
+			OSA_ERROR("Failed to copy data to user space\n");
+			return -EFAULT;
+		}
+		break;
+	}
+	case PDM_SENSOR_SET_WOM:
+	{
+		if (copy_from_user(&wom, (void __user *)arg, sizeof(wom))) {
+			OSA_ERROR("Failed to copy data from user space\n");
+			return -EFAULT;
+		}
+
+		status = pdm_sensor_set_wom(client, &wom);
+		break;
+	}
+	case PDM_SENSOR_SET_IMU_CONFIG:
+	{
+		if (copy_from_user(&imu_config, (void __user *)arg, sizeof(imu_config))) {
+			OSA_ERROR("Failed to copy data from user space\n");
+			return -EFAULT;
+		}
+
+		sensor_priv = pdm_client_get_private_data(client);
+		if (!sensor_priv->set_imu_config) {
+			OSA_ERROR("set_imu_config not supported\n");
+			return -ENOTSUPP;
+		}
+
+		mutex_lock(&sensor_priv->lock);
+		status = sensor_priv->set_imu_config(client, &imu_config);
+		mutex_unlock(&sensor_priv->lock);
+		break;
+	}
+	case PDM_SENSOR_GET_IMU_CONFIG:
+	{
+		sensor_priv = pdm_client_get_private_data(client);
+		if (!sensor_priv->get_imu_config) {
+			OSA_ERROR("get_imu_config not supported\n");
+			return -ENOTSUPP;
+		}
+
+		memset(&imu_config, 0, sizeof(imu_config));
+		mutex_lock(&sensor_priv->lock);
+		status = sensor_priv->get_imu_config(client, &imu_config);
+		mutex_unlock(&sensor_priv->lock);
+		if (status) {
+			OSA_ERROR("Failed to get imu config: %d\n", status);
+			return status;
+		}
+
+		if (copy_to_user((void __user *)arg, &imu_config, sizeof(imu_config))) {
+			OSA_ERROR("Failed to copy data to user space\n");
+			return -EFAULT;
+		}
+		break;
+	}
+	case PDM_SENSOR_SET_MODE:
+	{
+		if (copy_from_user(&mode, (void __user *)arg, sizeof(mode))) {
+			OSA_ERROR("Failed to copy data from user space\n");
+			return -EFAULT;
+		}
+
+		sensor_priv = pdm_client_get_private_data(client);
+		if (!sensor_priv->set_mode) {
+			OSA_ERROR("set_mode not supported\n");
+			return -ENOTSUPP;
+		}
+
+		mutex_lock(&sensor_priv->lock);
+		status = sensor_priv->set_mode(client, mode);
+		mutex_unlock(&sensor_priv->lock);
+		break;
+	}
+	case PDM_SENSOR_GET_MODE:
+	{
+		sensor_priv = pdm_client_get_private_data(client);
+		if (!sensor_priv->get_mode) {
+			OSA_ERROR("get_mode not supported\n");
+			return -ENOTSUPP;
+		}
+
+		status = sensor_priv->get_mode(client, &mode);
+		if (status) {
+			OSA_ERROR("Failed to get mode: %d\n", status);
+			return status;
+		}
+
+		if (copy_to_user((void __user *)arg, &mode, sizeof(mode))) {
+			OSA_ERROR("Failed to copy data to user space\n");
+			return -EFAULT;
+		}
+		break;
+	}
+	case PDM_SENSOR_READ_SAMPLE:
+	{
+		if (copy_from_user(&sample, (void __user *)arg, sizeof(sample))) {
+			OSA_ERROR("Failed to copy data from user space\n");
+			return -EFAULT;
+		}
+
+		status = pdm_sensor_read_data(client, sample.type, &sample.value, &timestamp);
+		if (status) {
+			OSA_ERROR("Failed to read sensor sample: %d\n", status);
+			return status;
+		}
+		sample.timestamp = timestamp;
+
+		if (copy_to_user((void __user *)arg, &sample, sizeof(sample))) {
+			OSA_ERROR("Failed to copy data to user space\n");
+			return -EFAULT;
+		}
+		break;
+	}
+	case PDM_SENSOR_GROUP_TRIGGER:
+	{
+		group = memdup_user((void __user *)arg, sizeof(*group));
+		if (IS_ERR(group)) {
+			OSA_ERROR("Failed to copy data from user space\n");
+			return PTR_ERR(group);
+		}
+
+		status = pdm_sensor_group_trigger(group);
+		if (!status && copy_to_user((void __user *)arg, group, sizeof(*group))) {
+			OSA_ERROR("Failed to copy data to user space\n");
+			status = -EFAULT;
+		}
+		kfree(group);
+		break;
+	}
 	default:
 	{
 		OSA_ERROR("Unknown ioctl command: 0x%x\n", cmd);
@@ -101,7 +610,7 @@ static long pdm_sensor_ioctl(struct file *filp, unsigned int cmd, unsigned long
 }
 
 /**
- * @brief Reads information about available commands or SENSOR state/brightness.
+ * @brief Reads threshold events, or information about available commands when no threshold is armed.
  *
  * @param filp File pointer.
  * @param buf User buffer to write data into.
@@ -111,11 +620,16 @@ static long pdm_sensor_ioctl(struct file *filp, unsigned int cmd, unsigned long
  */
 static ssize_t pdm_sensor_read(struct file *filp, char __user *buf, size_t count, loff_t *ppos)
 {
+	struct pdm_client *client = filp->private_data;
 	const char help_info[] =
 		"Available commands:\n"
 		" > echo 1 type > /dev/pdm_sensor - Read SENSOR\n";
 	size_t len = strlen(help_info);
 
+	if (pdm_client_event_enabled(client)) {
+		return pdm_client_event_read(client, filp, buf, count);
+	}
+
 	if (*ppos >= len)
 		return 0;
 
@@ -144,6 +658,7 @@ static ssize_t pdm_sensor_write(struct file *filp, const char __user *buf, size_
 	ssize_t bytes_read;
 	unsigned int type;
 	unsigned int value;
+	u64 timestamp;
 	int cmd;
 
 	if (!client || count >= sizeof(kernel_buf)) {
@@ -165,7 +680,7 @@ static ssize_t pdm_sensor_write(struct file *filp, const char __user *buf, size_
 	switch (cmd) {
 		case PDM_SENSOR_CMD_READ: {
 			value = 0;
-			if (pdm_sensor_read_data(client, type, &value)) {
+			if (pdm_sensor_read_data(client, type, &value, &timestamp)) {
 				OSA_ERROR("pdm_dimmer_set_level failed\n");
 				return -EINVAL;
 			}
@@ -191,6 +706,8 @@ static ssize_t pdm_sensor_write(struct file *filp, const char __user *buf, size_
  */
 static int pdm_sensor_device_probe(struct pdm_device *pdmdev)
 {
+	struct pdm_sensor_priv *sensor_priv;
+	struct device_node *np;
 	struct pdm_client *client;
 	int status;
 
@@ -200,6 +717,17 @@ static int pdm_sensor_device_probe(struct pdm_device *pdmdev)
 		return PTR_ERR(client);
 	}
 
+	sensor_priv = pdm_client_get_private_data(client);
+	sensor_priv->client = client;
+	mutex_init(&sensor_priv->lock);
+	INIT_DELAYED_WORK(&sensor_priv->poll_work, pdm_sensor_poll_work_func);
+
+	np = pdm_client_get_of_node(client);
+	if (!np || of_property_read_u32(np, "poll-interval-ms", &sensor_priv->poll_interval_ms)
+		|| !sensor_priv->poll_interval_ms) {
+		sensor_priv->poll_interval_ms = PDM_SENSOR_POLL_INTERVAL_MS;
+	}
+
 	status = devm_pdm_client_register(sensor_adapter, client);
 	if (status) {
 		OSA_ERROR("SENSOR Adapter Add Device Failed, status=%d\n", status);
@@ -228,7 +756,14 @@ static int pdm_sensor_device_probe(struct pdm_device *pdmdev)
  */
 static void pdm_sensor_device_remove(struct pdm_device *pdmdev)
 {
+	struct pdm_sensor_priv *sensor_priv;
+
 	if (pdmdev && pdmdev->client) {
+		sensor_priv = pdm_client_get_private_data(pdmdev->client);
+		if (sensor_priv) {
+			cancel_delayed_work_sync(&sensor_priv->poll_work);
+		}
+		pdm_client_event_enable(pdmdev->client, false);
 		pdm_client_cleanup(pdmdev->client);
 	}
 }
@@ -240,6 +775,7 @@ static void pdm_sensor_device_remove(struct pdm_device *pdmdev)
  */
 static const struct of_device_id of_pdm_sensor_match[] = {
 	{ .compatible = "pdm-sensor-ap3216c",	 .data = &pdm_sensor_ap3216c_match_data},
+	{ .compatible = "pdm-sensor-icm20608",	 .data = &pdm_sensor_icm20608_match_data},
 	{},
 };
 MODULE_DEVICE_TABLE(of, of_pdm_sensor_match);
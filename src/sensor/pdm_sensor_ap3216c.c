@@ -1,5 +1,7 @@
 #include <linux/i2c.h>
 #include <linux/delay.h>
+#include <linux/interrupt.h>
+#include <linux/ktime.h>
 
 #include "pdm.h"
 #include "pdm_sensor_priv.h"
@@ -8,10 +10,49 @@
 #define AP3216C_SYSTEMCONG	0x00	/* 配置寄存器 */
 #define AP3216C_INTSTATUS	0x01	/* 中断状态寄存器 */
 #define AP3216C_INTCLEAR	0x02	/* 中断清除寄存器 */
+#define AP3216C_ALS_THRES_LOW	0x1A	/* ALS低阈值寄存器(低字节在前) */
+#define AP3216C_ALS_THRES_HIGH	0x1C	/* ALS高阈值寄存器(低字节在前) */
+#define AP3216C_PS_INTMODE	0x22	/* PS中断模式寄存器 */
+#define AP3216C_PS_THRES_LOW	0x2A	/* PS低阈值寄存器(低2位在前) */
+#define AP3216C_PS_THRES_HIGH	0x2C	/* PS高阈值寄存器(低2位在前) */
+
+#define AP3216C_INT_ALS		BIT(0)	/* ALS中断标志 */
+#define AP3216C_INT_PS		BIT(1)	/* PS中断标志 */
+
+#define AP3216C_ALS_MAX		0xFFFF	/* ALS数据最大值 */
+#define AP3216C_PS_MAX		0x3FF	/* PS数据最大值 */
 
 #define AP3216C_I2C_READ_MSG_COUNT	(2)	/* 读寄存器长度 */
 #define AP3216C_RESET_DELAY_MS		(50)	/* 复位延迟时间(ms) */
 
+#define AP3216C_MODE_ALS		BIT(0)	/* 模式包含ALS */
+#define AP3216C_MODE_PS_IR		BIT(1)	/* 模式包含PS+IR */
+#define AP3216C_MODE_ONCE		BIT(2)	/* 单次转换模式 */
+#define AP3216C_MODE_RESET		0x04	/* 软件复位 */
+
+#define AP3216C_ALS_CONV_US		(100000)	/* ALS转换时间(us) */
+#define AP3216C_PS_IR_CONV_US		(12500)		/* PS+IR转换时间(us) */
+
+/**
+ * @brief AP3216C driver private data.
+ */
+struct pdm_sensor_ap3216c_data {
+	struct mutex lock;		/* Serializes mode changes and one-shot conversions */
+	unsigned int mode;		/* Active enum pdm_sensor_mode */
+	ktime_t ready;			/* Time the first fresh sample of the active mode is available */
+	u64 irq_timestamp;		/* CLOCK_BOOTTIME ns of the last INT assertion */
+};
+
+static const char * const ap3216c_mode_names[] = {
+	[PDM_SENSOR_MODE_POWER_DOWN]	= "power-down",
+	[PDM_SENSOR_MODE_ALS]		= "als",
+	[PDM_SENSOR_MODE_PS_IR]		= "ps-ir",
+	[PDM_SENSOR_MODE_ALL]		= "all",
+	[PDM_SENSOR_MODE_ALS_ONCE]	= "als-once",
+	[PDM_SENSOR_MODE_PS_IR_ONCE]	= "ps-ir-once",
+	[PDM_SENSOR_MODE_ALL_ONCE]	= "all-once",
+};
+
 /**
  * @brief Data type and register mapping structure.
  */
@@ -50,39 +91,129 @@ static int pdm_sensor_ap3216c_write_reg(struct pdm_client *client, unsigned char
 	return (1 == i2c_transfer(client->hardware.i2c.client->adapter, &msg, 1)) ? 0 : -EREMOTEIO;
 }
 
+/**
+ * @brief Returns the conversion time of one cycle in the given mode.
+ */
+static unsigned int pdm_sensor_ap3216c_conv_us(unsigned int mode)
+{
+	unsigned int conv_us = 0;
+
+	if (mode & AP3216C_MODE_ALS) {
+		conv_us += AP3216C_ALS_CONV_US;
+	}
+	if (mode & AP3216C_MODE_PS_IR) {
+		conv_us += AP3216C_PS_IR_CONV_US;
+	}
+	return conv_us;
+}
+
+/**
+ * @brief Writes the operating mode and records when the first fresh sample is ready.
+ *
+ * Must be called with the driver lock held.
+ */
+static int pdm_sensor_ap3216c_write_mode(struct pdm_client *client, struct pdm_sensor_ap3216c_data *ap3216c,
+					 unsigned int mode)
+{
+	int status;
+
+	status = pdm_sensor_ap3216c_write_reg(client, AP3216C_SYSTEMCONG, mode);
+	if (status) {
+		OSA_ERROR("Failed to write mode %u to SYSTEMCONG register: %d\n", mode, status);
+		return status;
+	}
+
+	ap3216c->ready = ktime_add_us(ktime_get(), pdm_sensor_ap3216c_conv_us(mode));
+	return 0;
+}
+
+/**
+ * @brief Sleeps until the conversion started by the last mode write has completed.
+ */
+static void pdm_sensor_ap3216c_wait_ready(struct pdm_sensor_ap3216c_data *ap3216c)
+{
+	s64 remaining_us = ktime_us_delta(ap3216c->ready, ktime_get());
+
+	if (remaining_us > 0) {
+		usleep_range(remaining_us, remaining_us + remaining_us / 8 + 100);
+	}
+}
+
 /**
  * @brief Enables the AP3216C sensor by writing configuration values and ensuring reset delay.
  */
 static int pdm_sensor_ap3216c_enable(struct pdm_client *client)
 {
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_ap3216c_data *ap3216c = sensor_priv->hw_priv;
 	int status;
 
-	status = pdm_sensor_ap3216c_write_reg(client, AP3216C_SYSTEMCONG, 0x04);
+	status = pdm_sensor_ap3216c_write_reg(client, AP3216C_SYSTEMCONG, AP3216C_MODE_RESET);
 	if (status) {
 		OSA_ERROR("Failed to write reset value to SYSTEMCONG register: %d\n", status);
 		return status;
 	}
 	mdelay(AP3216C_RESET_DELAY_MS); // Ensure reset delay
 
-	status = pdm_sensor_ap3216c_write_reg(client, AP3216C_SYSTEMCONG, 0x03);
+	/* One-shot modes start a conversion per read, stay powered down until then */
+	status = pdm_sensor_ap3216c_write_mode(client, ap3216c,
+					       (ap3216c->mode & AP3216C_MODE_ONCE) ? PDM_SENSOR_MODE_POWER_DOWN : ap3216c->mode);
 	if (status) {
-		OSA_ERROR("Failed to write enable value to SYSTEMCONG register: %d\n", status);
 		return status;
 	}
 
-	OSA_DEBUG("AP3216C SENSOR Enabled.\n");
+	OSA_DEBUG("AP3216C SENSOR Enabled, mode: %s\n", ap3216c_mode_names[ap3216c->mode]);
+	return 0;
+}
+
+/**
+ * @brief Switches the operating mode.
+ */
+static int pdm_sensor_ap3216c_set_mode(struct pdm_client *client, unsigned int mode)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_ap3216c_data *ap3216c = sensor_priv->hw_priv;
+	int status;
+
+	if (mode >= ARRAY_SIZE(ap3216c_mode_names) || !ap3216c_mode_names[mode]) {
+		OSA_ERROR("Invalid mode: %u\n", mode);
+		return -EINVAL;
+	}
+
+	mutex_lock(&ap3216c->lock);
+	status = pdm_sensor_ap3216c_write_mode(client, ap3216c,
+					       (mode & AP3216C_MODE_ONCE) ? PDM_SENSOR_MODE_POWER_DOWN : mode);
+	if (!status) {
+		ap3216c->mode = mode;
+	}
+	mutex_unlock(&ap3216c->lock);
+
+	OSA_DEBUG("AP3216C mode: %s\n", ap3216c_mode_names[mode]);
+	return status;
+}
+
+static int pdm_sensor_ap3216c_get_mode(struct pdm_client *client, unsigned int *mode)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_ap3216c_data *ap3216c = sensor_priv->hw_priv;
+
+	*mode = READ_ONCE(ap3216c->mode);
 	return 0;
 }
 
 /**
- * @brief Reads data from the AP3216C sensor based on the specified type info.
+ * @brief Reads the latest conversion result of the specified type from the data registers.
+ *
+ * @timestamp is taken in the middle of the low byte transfer, which latches the result.
  */
-static int pdm_sensor_ap3216c_read(struct pdm_client *client, unsigned int type, unsigned int *val)
+static int pdm_sensor_ap3216c_read_raw(struct pdm_client *client, unsigned int type, unsigned int *val,
+				       u64 *timestamp)
 {
 	const struct ap3216c_data_type_info *info = NULL;
 	int status = -EINVAL;
 	unsigned short value;
 	unsigned char data_low, data_high;
+	u64 start;
 
 	for (size_t i = 0; i < ARRAY_SIZE(ap3216c_data_types); ++i) {
 		if (ap3216c_data_types[i].type == type) {
@@ -96,11 +227,13 @@ static int pdm_sensor_ap3216c_read(struct pdm_client *client, unsigned int type,
 		return -EINVAL;
 	}
 
+	start = ktime_get_boottime_ns();
 	status = pdm_sensor_ap3216c_read_reg(client, info->low_reg, &data_low, sizeof(data_low));
 	if (status) {
 		OSA_ERROR("read reg low_data failed, status: %d\n", status);
 		return status;
 	}
+	*timestamp = start + (ktime_get_boottime_ns() - start) / 2;
 
 	status = pdm_sensor_ap3216c_read_reg(client, info->high_reg, &data_high, sizeof(data_high));
 	if (status) {
@@ -123,6 +256,183 @@ static int pdm_sensor_ap3216c_read(struct pdm_client *client, unsigned int type,
 	return 0;
 }
 
+/**
+ * @brief Reads a fresh sample, blocking only until the conversion of the active mode is done.
+ *
+ * One-shot modes start a conversion for the requested channel and wait for it, continuous
+ * modes only wait right after a mode change.
+ */
+static int pdm_sensor_ap3216c_read(struct pdm_client *client, unsigned int type, unsigned int *val, u64 *timestamp)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_ap3216c_data *ap3216c = sensor_priv->hw_priv;
+	unsigned int function;
+	int status;
+
+	function = (type == PDM_SENSOR_TYPE_ALS) ? AP3216C_MODE_ALS : AP3216C_MODE_PS_IR;
+
+	mutex_lock(&ap3216c->lock);
+	if (!(ap3216c->mode & function)) {
+		OSA_DEBUG("Type %u is not measured in mode %s\n", type, ap3216c_mode_names[ap3216c->mode]);
+		status = -ENODATA;
+		goto unlock;
+	}
+
+	if (ap3216c->mode & AP3216C_MODE_ONCE) {
+		status = pdm_sensor_ap3216c_write_mode(client, ap3216c, AP3216C_MODE_ONCE | function);
+		if (status) {
+			goto unlock;
+		}
+	}
+
+	pdm_sensor_ap3216c_wait_ready(ap3216c);
+	status = pdm_sensor_ap3216c_read_raw(client, type, val, timestamp);
+
+unlock:
+	mutex_unlock(&ap3216c->lock);
+	return status;
+}
+
+/**
+ * @brief Writes a 16-bit ALS threshold, low byte first.
+ */
+static int pdm_sensor_ap3216c_write_als_thres(struct pdm_client *client, unsigned char reg, unsigned int value)
+{
+	int status;
+
+	status = pdm_sensor_ap3216c_write_reg(client, reg, value & 0xFF);
+	if (status) {
+		return status;
+	}
+	return pdm_sensor_ap3216c_write_reg(client, reg + 1, (value >> 8) & 0xFF);
+}
+
+/**
+ * @brief Writes a 10-bit PS threshold, bits [1:0] first then bits [9:2].
+ */
+static int pdm_sensor_ap3216c_write_ps_thres(struct pdm_client *client, unsigned char reg, unsigned int value)
+{
+	int status;
+
+	status = pdm_sensor_ap3216c_write_reg(client, reg, value & 0x03);
+	if (status) {
+		return status;
+	}
+	return pdm_sensor_ap3216c_write_reg(client, reg + 1, (value >> 2) & 0xFF);
+}
+
+/**
+ * @brief Programs the ALS or PS interrupt window, the chip interrupts when a sample leaves [low, high].
+ */
+static int pdm_sensor_ap3216c_set_window(struct pdm_client *client, unsigned int type, unsigned int low, unsigned int high)
+{
+	int status;
+
+	if (client->hardware.i2c.client->irq <= 0) {
+		return -EOPNOTSUPP;
+	}
+
+	switch (type) {
+	case PDM_SENSOR_TYPE_ALS:
+		status = pdm_sensor_ap3216c_write_als_thres(client, AP3216C_ALS_THRES_LOW, min_t(unsigned int, low, AP3216C_ALS_MAX));
+		if (!status) {
+			status = pdm_sensor_ap3216c_write_als_thres(client, AP3216C_ALS_THRES_HIGH, min_t(unsigned int, high, AP3216C_ALS_MAX));
+		}
+		break;
+	case PDM_SENSOR_TYPE_PS:
+		status = pdm_sensor_ap3216c_write_ps_thres(client, AP3216C_PS_THRES_LOW, min_t(unsigned int, low, AP3216C_PS_MAX));
+		if (!status) {
+			status = pdm_sensor_ap3216c_write_ps_thres(client, AP3216C_PS_THRES_HIGH, min_t(unsigned int, high, AP3216C_PS_MAX));
+		}
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	if (status) {
+		OSA_ERROR("Failed to write threshold of type %u: %d\n", type, status);
+	}
+	return status;
+}
+
+/**
+ * @brief Hard interrupt handler, timestamps the INT assertion.
+ */
+static irqreturn_t pdm_sensor_ap3216c_irq_timestamp(int irq, void *data)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(data);
+	struct pdm_sensor_ap3216c_data *ap3216c = sensor_priv->hw_priv;
+
+	ap3216c->irq_timestamp = ktime_get_boottime_ns();
+	return IRQ_WAKE_THREAD;
+}
+
+/**
+ * @brief Threaded interrupt handler, reading the data registers also clears the interrupt.
+ */
+static irqreturn_t pdm_sensor_ap3216c_irq_handler(int irq, void *data)
+{
+	struct pdm_client *client = data;
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_ap3216c_data *ap3216c = sensor_priv->hw_priv;
+	unsigned char int_status;
+	unsigned int value;
+	u64 timestamp;
+
+	if (pdm_sensor_ap3216c_read_reg(client, AP3216C_INTSTATUS, &int_status, sizeof(int_status))) {
+		return IRQ_NONE;
+	}
+
+	if (!(int_status & (AP3216C_INT_ALS | AP3216C_INT_PS))) {
+		return IRQ_NONE;
+	}
+
+	if ((int_status & AP3216C_INT_ALS)
+		&& !pdm_sensor_ap3216c_read_raw(client, PDM_SENSOR_TYPE_ALS, &value, &timestamp)) {
+		pdm_sensor_threshold_report(client, PDM_SENSOR_TYPE_ALS, value, ap3216c->irq_timestamp);
+	}
+
+	if ((int_status & AP3216C_INT_PS)
+		&& !pdm_sensor_ap3216c_read_raw(client, PDM_SENSOR_TYPE_PS, &value, &timestamp)) {
+		pdm_sensor_threshold_report(client, PDM_SENSOR_TYPE_PS, value, ap3216c->irq_timestamp);
+	}
+
+	return IRQ_HANDLED;
+}
+
+/**
+ * @brief Requests the INT line and opens the threshold windows so nothing fires until armed.
+ */
+static int pdm_sensor_ap3216c_irq_setup(struct pdm_client *client)
+{
+	struct i2c_client *i2c = client->hardware.i2c.client;
+	int status;
+
+	status = pdm_sensor_ap3216c_write_reg(client, AP3216C_INTCLEAR, 0x00);
+	if (!status) {
+		status = pdm_sensor_ap3216c_write_reg(client, AP3216C_PS_INTMODE, 0x00);
+	}
+	if (!status) {
+		status = pdm_sensor_ap3216c_set_window(client, PDM_SENSOR_TYPE_ALS, 0, UINT_MAX);
+	}
+	if (!status) {
+		status = pdm_sensor_ap3216c_set_window(client, PDM_SENSOR_TYPE_PS, 0, UINT_MAX);
+	}
+	if (status) {
+		OSA_ERROR("Failed to configure AP3216C interrupt: %d\n", status);
+		return status;
+	}
+
+	status = request_threaded_irq(i2c->irq, pdm_sensor_ap3216c_irq_timestamp, pdm_sensor_ap3216c_irq_handler,
+				      IRQF_ONESHOT, dev_name(&client->dev), client);
+	if (status) {
+		OSA_ERROR("Failed to request irq %d: %d\n", i2c->irq, status);
+		return status;
+	}
+
+	return 0;
+}
+
 /**
  * @brief Initializes the AP3216C sensor settings.
  */
@@ -130,6 +440,8 @@ static int pdm_sensor_ap3216c_setup(struct pdm_client *client)
 {
 	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
 	const struct device_node *np = pdm_client_get_of_node(client);
+	struct pdm_sensor_ap3216c_data *ap3216c;
+	unsigned int mode;
 	int status;
 
 	if (!client || !sensor_priv || !np) {
@@ -137,7 +449,25 @@ static int pdm_sensor_ap3216c_setup(struct pdm_client *client)
 		return -EINVAL;
 	}
 
+	ap3216c = devm_kzalloc(&client->pdmdev->dev, sizeof(*ap3216c), GFP_KERNEL);
+	if (!ap3216c) {
+		OSA_ERROR("Failed to allocate AP3216C data\n");
+		return -ENOMEM;
+	}
+	mutex_init(&ap3216c->lock);
+
+	ap3216c->mode = PDM_SENSOR_MODE_ALL;
+	for (mode = 0; mode < ARRAY_SIZE(ap3216c_mode_names); mode++) {
+		if (ap3216c_mode_names[mode] && of_property_match_string(np, "operating-mode", ap3216c_mode_names[mode]) >= 0) {
+			ap3216c->mode = mode;
+			break;
+		}
+	}
+
+	sensor_priv->hw_priv = ap3216c;
 	sensor_priv->read = pdm_sensor_ap3216c_read;
+	sensor_priv->set_mode = pdm_sensor_ap3216c_set_mode;
+	sensor_priv->get_mode = pdm_sensor_ap3216c_get_mode;
 	client->hardware.i2c.client = to_i2c_client(client->pdmdev->dev.parent);
 
 	status = pdm_sensor_ap3216c_enable(client);
@@ -146,12 +476,34 @@ static int pdm_sensor_ap3216c_setup(struct pdm_client *client)
 		return status;
 	}
 
+	if (client->hardware.i2c.client->irq > 0) {
+		status = pdm_sensor_ap3216c_irq_setup(client);
+		if (status) {
+			OSA_WARN("AP3216C interrupt unavailable, thresholds fall back to polling\n");
+		} else {
+			sensor_priv->set_window = pdm_sensor_ap3216c_set_window;
+		}
+	}
+
 	OSA_DEBUG("PDM SENSOR Setup: %s\n", dev_name(&client->dev));
 
 	return 0;
 }
 
+/**
+ * @brief Releases the AP3216C interrupt.
+ */
+static void pdm_sensor_ap3216c_cleanup(struct pdm_client *client)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+
+	if (sensor_priv && sensor_priv->set_window) {
+		free_irq(client->hardware.i2c.client->irq, client);
+		sensor_priv->set_window = NULL;
+	}
+}
+
 const struct pdm_client_match_data pdm_sensor_ap3216c_match_data = {
 	.setup = pdm_sensor_ap3216c_setup,
-	.cleanup = NULL,
+	.cleanup = pdm_sensor_ap3216c_cleanup,
 };
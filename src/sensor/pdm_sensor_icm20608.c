@@ -1,122 +1,343 @@
 #include <linux/spi/spi.h>
 #include <linux/delay.h>
+#include <linux/interrupt.h>
 
 #include "pdm.h"
 #include "pdm_sensor_priv.h"
 #include "pdm_sensor_icm20608.h"
 
-static int pdm_sensor_icm20608_read_reg(struct pdm_client *client, u8 reg, unsigned char *buf)
+/**
+ * @brief Runs one full-duplex transfer through the preallocated DMA-safe buffers.
+ *
+ * Must be called with icm->xfer_lock held, @len includes the address byte.
+ */
+static int pdm_sensor_icm20608_xfer(struct pdm_client *client, unsigned int len)
 {
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_icm20608_data *icm = sensor_priv->hw_priv;
 	struct spi_transfer xfer;
 	struct spi_message msg;
-	unsigned char txd[PDM_SENSOR_ICM20608_RW_LEN];
-	unsigned char rxd[PDM_SENSOR_ICM20608_RW_LEN];
 	int status;
 
-	if (!client || client->hardware.spi.spidev) {
-		OSA_ERROR("invalid argument\n");
-		return -EINVAL;
-	}
-
 	memset(&xfer, 0, sizeof(xfer));
-	memset(&txd, 0, sizeof(txd));
-	memset(&rxd, 0, sizeof(rxd));
-
-	txd[0] = reg | BIT(8);
-	xfer.tx_buf = txd;
-	xfer.rx_buf = rxd;
-	xfer.len = PDM_SENSOR_ICM20608_RW_LEN;
+	xfer.tx_buf = icm->tx;
+	xfer.rx_buf = icm->rx;
+	xfer.len = len;
 
 	spi_message_init(&msg);
 	spi_message_add_tail(&xfer, &msg);
 
 	status = spi_sync(client->hardware.spi.spidev, &msg);
-	if(status) {
-		OSA_ERROR("syi_sync error: %d\n", status);
+	if (status) {
+		OSA_ERROR("spi_sync error: %d\n", status);
 	}
 
 	return status;
 }
 
-static int pdm_sensor_icm20608_write_reg(struct pdm_client *client, u8 reg, u8 value)
+/**
+ * @brief Reads @len consecutive registers starting at @reg in a single transfer.
+ */
+static int pdm_sensor_icm20608_read_burst(struct pdm_client *client, u8 reg, unsigned char *buf, unsigned int len)
 {
-	struct spi_transfer xfer;
-	struct spi_message msg;
-	unsigned char txd[PDM_SENSOR_ICM20608_RW_LEN];
-	unsigned char rxd[PDM_SENSOR_ICM20608_RW_LEN];
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_icm20608_data *icm;
 	int status;
 
-	if (!client || client->hardware.spi.spidev) {
+	if (!client || !client->hardware.spi.spidev || !sensor_priv || !sensor_priv->hw_priv
+		|| len > PDM_SENSOR_ICM20608_BURST_MAX) {
 		OSA_ERROR("invalid argument\n");
 		return -EINVAL;
 	}
+	icm = sensor_priv->hw_priv;
 
-	memset(&xfer, 0, sizeof(xfer));
-	memset(&txd, 0, sizeof(txd));
-	memset(&rxd, 0, sizeof(rxd));
+	mutex_lock(&icm->xfer_lock);
+	memset(icm->tx, 0, len + 1);
+	icm->tx[0] = reg | PDM_SENSOR_ICM20608_READ_FLAG;
+	status = pdm_sensor_icm20608_xfer(client, len + 1);
+	if (!status) {
+		memcpy(buf, icm->rx + 1, len);
+	}
+	mutex_unlock(&icm->xfer_lock);
 
-	txd[0] = reg & ~BIT(8);
+	return status;
+}
 
-	xfer.tx_buf = &txd;
-	xfer.rx_buf = &rxd;
-	xfer.len = PDM_SENSOR_ICM20608_RW_LEN;
-	spi_message_init(&msg);
-	spi_message_add_tail(&xfer, &msg);
+static int pdm_sensor_icm20608_read_reg(struct pdm_client *client, u8 reg, unsigned char *buf)
+{
+	return pdm_sensor_icm20608_read_burst(client, reg, buf, 1);
+}
 
-	status = spi_sync(client->hardware.spi.spidev, &msg);
-	if(status) {
-		OSA_ERROR("syi_sync error: %d\n", status);
+static int pdm_sensor_icm20608_write_reg(struct pdm_client *client, u8 reg, u8 value)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_icm20608_data *icm;
+	int status;
+
+	if (!client || !client->hardware.spi.spidev || !sensor_priv || !sensor_priv->hw_priv) {
+		OSA_ERROR("invalid argument\n");
+		return -EINVAL;
 	}
+	icm = sensor_priv->hw_priv;
+
+	mutex_lock(&icm->xfer_lock);
+	icm->tx[0] = reg & ~PDM_SENSOR_ICM20608_READ_FLAG;
+	icm->tx[1] = value;
+	status = pdm_sensor_icm20608_xfer(client, PDM_SENSOR_ICM20608_RW_LEN);
+	mutex_unlock(&icm->xfer_lock);
 
 	return status;
 }
 
-static int pdm_sensor_ap3216c_read(struct pdm_client *client, unsigned int type, unsigned int *val)
+static int pdm_sensor_icm20608_read(struct pdm_client *client, unsigned int type, unsigned int *val, u64 *timestamp)
 {
-	unsigned char value;
-	unsigned char offset;
+	unsigned char data[ICM20_GYRO_ZOUT_L - ICM20_ACCEL_XOUT_H + 1];
+	unsigned int offset;
 	int status;
 
-	for (offset = ICM20_ACCEL_XOUT_H; offset <= ICM20_GYRO_ZOUT_L; offset++) {
-		status = pdm_sensor_icm20608_read_reg(client, offset, &value);
-		if (status) {
-			OSA_ERROR("read reg low_data failed, status: %d\n", status);
-			return status;
-		}
-		OSA_VAR_UCHAR_NUMERIC(value);
+	/* Channels are laid out in burst order, one big-endian word each */
+	if (type < PDM_SENSOR_TYPE_ACCEL_X || type > PDM_SENSOR_TYPE_GYRO_Z) {
+		OSA_ERROR("Invalid sensor type: %u\n", type);
+		return -EINVAL;
+	}
+	offset = (type - PDM_SENSOR_TYPE_ACCEL_X) * 2;
+
+	*timestamp = ktime_get_boottime_ns();
+
+	/* One burst keeps the accel, temperature and gyro samples of the same instant */
+	status = pdm_sensor_icm20608_read_burst(client, ICM20_ACCEL_XOUT_H, data, sizeof(data));
+	if (status) {
+		OSA_ERROR("read sample registers failed, status: %d\n", status);
+		return status;
+	}
+
+	*val = (unsigned int)(int)(s16)((data[offset] << 8) | data[offset + 1]);
+	return 0;
+}
+
+/**
+ * @brief Writes the measurement configuration (rate, ranges, filters) and powers up all axes.
+ */
+static int pdm_sensor_icm20608_configure(struct pdm_client *client)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_icm20608_data *icm = sensor_priv->hw_priv;
+	const struct pdm_sensor_imu_config *config = &icm->config;
+	int status = 0;
+
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_SMPLRT_DIV, config->sample_div);					/* 输出速率 = 1kHz/(1+div)		*/
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_GYRO_CONFIG, config->gyro_range << ICM20_FS_SEL_SHIFT);		/* 陀螺仪量程 				*/
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_ACCEL_CONFIG, config->accel_range << ICM20_FS_SEL_SHIFT);	/* 加速度计量程 			*/
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_CONFIG, config->gyro_dlpf);					/* 陀螺仪低通滤波 			*/
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_ACCEL_CONFIG2, config->accel_dlpf);				/* 加速度计低通滤波 			*/
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_PWR_MGMT_2, 0x00);						/* 打开加速度计和陀螺仪所有轴 		*/
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_LP_MODE_CFG, 0x00);						/* 关闭低功耗 				*/
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_FIFO_EN, 0x00);							/* 关闭FIFO				*/
+
+	return status ? -EIO : 0;
+}
+
+/**
+ * @brief Validates an IMU configuration against the register field widths.
+ */
+static int pdm_sensor_icm20608_check_config(const struct pdm_sensor_imu_config *config)
+{
+	if (config->sample_div > ICM20_SMPLRT_DIV_MAX
+		|| config->gyro_range > ICM20_FS_SEL_MAX || config->accel_range > ICM20_FS_SEL_MAX
+		|| config->gyro_dlpf > ICM20_DLPF_CFG_MAX || config->accel_dlpf > ICM20_DLPF_CFG_MAX) {
+		OSA_ERROR("Invalid config: div %u, range %u/%u, dlpf %u/%u\n",
+			  config->sample_div, config->gyro_range, config->accel_range,
+			  config->gyro_dlpf, config->accel_dlpf);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+/**
+ * @brief Applies a new measurement configuration, refused while in wake-on-motion mode.
+ */
+static int pdm_sensor_icm20608_set_imu_config(struct pdm_client *client, const struct pdm_sensor_imu_config *config)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_icm20608_data *icm = sensor_priv->hw_priv;
+	struct pdm_sensor_imu_config old;
+	int status;
+
+	status = pdm_sensor_icm20608_check_config(config);
+	if (status) {
+		return status;
+	}
+
+	if (icm->wom) {
+		OSA_ERROR("Cannot reconfigure while wake-on-motion is active\n");
+		return -EBUSY;
+	}
+
+	old = icm->config;
+	icm->config = *config;
+	status = pdm_sensor_icm20608_configure(client);
+	if (status) {
+		OSA_ERROR("Failed to apply config: %d\n", status);
+		icm->config = old;
+		pdm_sensor_icm20608_configure(client);
+		return status;
 	}
 
+	OSA_DEBUG("ICM20608 config: div %u, range %u/%u, dlpf %u/%u\n",
+		  config->sample_div, config->gyro_range, config->accel_range,
+		  config->gyro_dlpf, config->accel_dlpf);
 	return 0;
 }
 
+static int pdm_sensor_icm20608_get_imu_config(struct pdm_client *client, struct pdm_sensor_imu_config *config)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_icm20608_data *icm = sensor_priv->hw_priv;
+
+	*config = icm->config;
+	return 0;
+}
+
+/**
+ * @brief Reads the default measurement configuration from the device tree.
+ */
+static int pdm_sensor_icm20608_parse_dt(const struct device_node *np, struct pdm_sensor_imu_config *config)
+{
+	config->sample_div = ICM20_DEFAULT_SMPLRT_DIV;
+	config->gyro_range = ICM20_DEFAULT_GYRO_RANGE;
+	config->accel_range = ICM20_DEFAULT_ACCEL_RANGE;
+	config->gyro_dlpf = ICM20_DEFAULT_GYRO_DLPF;
+	config->accel_dlpf = ICM20_DEFAULT_ACCEL_DLPF;
+
+	of_property_read_u32(np, "smplrt-div", &config->sample_div);
+	of_property_read_u32(np, "gyro-range", &config->gyro_range);
+	of_property_read_u32(np, "accel-range", &config->accel_range);
+	of_property_read_u32(np, "gyro-dlpf", &config->gyro_dlpf);
+	of_property_read_u32(np, "accel-dlpf", &config->accel_dlpf);
+
+	return pdm_sensor_icm20608_check_config(config);
+}
+
 static int pdm_sensor_icm20608_init(struct pdm_client *client)
 {
 	int status;
 	u8 value = 0;
 
-	pdm_sensor_icm20608_write_reg(client, ICM20_PWR_MGMT_1, 0x80);
+	status = pdm_sensor_icm20608_write_reg(client, ICM20_PWR_MGMT_1, ICM20_PWR_MGMT_1_RESET);
+	if (status) {
+		OSA_ERROR("Failed to reset ICM20608, status = %d\n", status);
+		return status;
+	}
 	mdelay(50);
-	pdm_sensor_icm20608_write_reg(client, ICM20_PWR_MGMT_1, 0x01);
+
+	status = pdm_sensor_icm20608_write_reg(client, ICM20_PWR_MGMT_1, ICM20_PWR_MGMT_1_CLKSEL_AUTO);
+	if (status) {
+		OSA_ERROR("Failed to select ICM20608 clock, status = %d\n", status);
+		return status;
+	}
 	mdelay(50);
 
 	status = pdm_sensor_icm20608_read_reg(client, ICM20_WHO_AM_I, &value);
 	if (status) {
 		OSA_ERROR("Failed to read ICM20608 ID, status = %d\n", status);
+		return status;
 	}
 	printk("ICM20608 ID = %#X\r\n", value);
 
-	pdm_sensor_icm20608_write_reg(client, ICM20_SMPLRT_DIV, 0x00);		/* 输出速率是内部采样率				*/
-	pdm_sensor_icm20608_write_reg(client, ICM20_GYRO_CONFIG, 0x18);		/* 陀螺仪±2000dps量程 			*/
-	pdm_sensor_icm20608_write_reg(client, ICM20_ACCEL_CONFIG, 0x18);	/* 加速度计±16G量程 				*/
-	pdm_sensor_icm20608_write_reg(client, ICM20_CONFIG, 0x04);		/* 陀螺仪低通滤波BW=20Hz 			*/
-	pdm_sensor_icm20608_write_reg(client, ICM20_ACCEL_CONFIG2, 0x04);	/* 加速度计低通滤波BW=21.2Hz 			*/
-	pdm_sensor_icm20608_write_reg(client, ICM20_PWR_MGMT_2, 0x00);		/* 打开加速度计和陀螺仪所有轴 			*/
-	pdm_sensor_icm20608_write_reg(client, ICM20_LP_MODE_CFG, 0x00);		/* 关闭低功耗 				*/
-	pdm_sensor_icm20608_write_reg(client, ICM20_FIFO_EN, 0x00);		/* 关闭FIFO				*/
+	return pdm_sensor_icm20608_configure(client);
+}
+
+/**
+ * @brief Enters or leaves the accelerometer low-power wake-on-motion mode.
+ *
+ * Entering follows the datasheet sequence: gyro off, DLPF bypassed, WOM interrupt and
+ * threshold set, motion compare enabled, wake-up rate set, then cycle mode.
+ */
+static int pdm_sensor_icm20608_set_wom(struct pdm_client *client, const struct pdm_sensor_wom_config *config)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_icm20608_data *icm = sensor_priv->hw_priv;
+	unsigned int threshold;
+	int status = 0;
 
+	if (!config->enable) {
+		status |= pdm_sensor_icm20608_write_reg(client, ICM20_INT_ENABLE, 0x00);
+		status |= pdm_sensor_icm20608_write_reg(client, ICM20_ACCEL_INTEL_CTRL, 0x00);
+		status |= pdm_sensor_icm20608_write_reg(client, ICM20_PWR_MGMT_1, ICM20_PWR_MGMT_1_CLKSEL_AUTO);
+		if (status) {
+			return -EIO;
+		}
+		icm->wom = false;
+		return pdm_sensor_icm20608_configure(client);
+	}
+
+	if (config->wake_div > 0xFF) {
+		OSA_ERROR("Invalid wake divider: %u\n", config->wake_div);
+		return -EINVAL;
+	}
+
+	threshold = DIV_ROUND_UP(config->threshold_mg, ICM20_WOM_THR_MG_PER_LSB);
+	threshold = clamp_t(unsigned int, threshold, 1, 0xFF);
+
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_PWR_MGMT_1, ICM20_PWR_MGMT_1_CLKSEL_AUTO);
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_PWR_MGMT_2, ICM20_PWR_MGMT_2_DISABLE_GYRO);
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_ACCEL_CONFIG2, ICM20_ACCEL_CONFIG2_FCHOICE_B | 0x01);
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_INT_ENABLE, ICM20_INT_WOM_MASK);
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_ACCEL_WOM_THR, threshold);
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_ACCEL_INTEL_CTRL, ICM20_ACCEL_INTEL_EN | ICM20_ACCEL_INTEL_MODE);
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_SMPLRT_DIV, config->wake_div);
+	status |= pdm_sensor_icm20608_write_reg(client, ICM20_PWR_MGMT_1, ICM20_PWR_MGMT_1_CYCLE | ICM20_PWR_MGMT_1_CLKSEL_AUTO);
+	if (status) {
+		OSA_ERROR("Failed to enter wake-on-motion mode\n");
+		return -EIO;
+	}
+	icm->wom = true;
+
+	OSA_DEBUG("ICM20608 wake-on-motion: %u mg, div %u\n", threshold * ICM20_WOM_THR_MG_PER_LSB, config->wake_div);
 	return 0;
 }
 
+/**
+ * @brief Hard interrupt handler, timestamps the INT assertion.
+ */
+static irqreturn_t pdm_sensor_icm20608_irq_timestamp(int irq, void *data)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(data);
+	struct pdm_sensor_icm20608_data *icm = sensor_priv->hw_priv;
+
+	icm->irq_timestamp = ktime_get_boottime_ns();
+	return IRQ_WAKE_THREAD;
+}
+
+/**
+ * @brief Threaded interrupt handler, reading INT_STATUS clears the interrupt.
+ */
+static irqreturn_t pdm_sensor_icm20608_irq_handler(int irq, void *data)
+{
+	struct pdm_client *client = data;
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+	struct pdm_sensor_icm20608_data *icm = sensor_priv->hw_priv;
+	struct pdm_client_event event;
+	unsigned char int_status;
+
+	if (pdm_sensor_icm20608_read_reg(client, ICM20_INT_STATUS, &int_status)) {
+		return IRQ_NONE;
+	}
+
+	if (!(int_status & ICM20_INT_WOM_MASK)) {
+		return IRQ_NONE;
+	}
+
+	memset(&event, 0, sizeof(event));
+	event.type = PDM_CLIENT_EVENT_MOTION;
+	event.code = (int_status & ICM20_INT_WOM_MASK) >> ICM20_INT_WOM_SHIFT;
+	event.value = int_status;
+	event.timestamp = icm->irq_timestamp;
+	pdm_client_event_push(client, &event);
+
+	return IRQ_HANDLED;
+}
+
 /**
  * @brief Initializes the ICM20608 sensor settings.
  */
@@ -124,6 +345,8 @@ static int pdm_sensor_icm20608_setup(struct pdm_client *client)
 {
 	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
 	const struct device_node *np = pdm_client_get_of_node(client);
+	struct pdm_sensor_icm20608_data *icm;
+	struct spi_device *spi;
 	int status;
 
 	if (!client || !sensor_priv || !np) {
@@ -131,22 +354,70 @@ static int pdm_sensor_icm20608_setup(struct pdm_client *client)
 		return -EINVAL;
 	}
 
-	sensor_priv->read = pdm_sensor_ap3216c_read;
-	client->hardware.spi.spidev = to_spi_device(client->pdmdev->dev.parent);
+	icm = devm_kzalloc(&client->pdmdev->dev, sizeof(*icm), GFP_KERNEL);
+	if (!icm) {
+		OSA_ERROR("Failed to allocate ICM20608 data\n");
+		return -ENOMEM;
+	}
+
+	/* Separate kmalloc'ed buffers, stack memory must not be used for SPI DMA */
+	icm->tx = devm_kzalloc(&client->pdmdev->dev, PDM_SENSOR_ICM20608_BURST_MAX + 1, GFP_KERNEL);
+	icm->rx = devm_kzalloc(&client->pdmdev->dev, PDM_SENSOR_ICM20608_BURST_MAX + 1, GFP_KERNEL);
+	if (!icm->tx || !icm->rx) {
+		OSA_ERROR("Failed to allocate ICM20608 transfer buffers\n");
+		return -ENOMEM;
+	}
+	mutex_init(&icm->xfer_lock);
+
+	status = pdm_sensor_icm20608_parse_dt(np, &icm->config);
+	if (status) {
+		OSA_ERROR("Invalid ICM20608 DT configuration\n");
+		return status;
+	}
+
+	sensor_priv->hw_priv = icm;
+	sensor_priv->read = pdm_sensor_icm20608_read;
+	sensor_priv->set_imu_config = pdm_sensor_icm20608_set_imu_config;
+	sensor_priv->get_imu_config = pdm_sensor_icm20608_get_imu_config;
+	spi = to_spi_device(client->pdmdev->dev.parent);
+	client->hardware.spi.spidev = spi;
 
 	status = pdm_sensor_icm20608_init(client);
 	if (status) {
-		OSA_ERROR("Failed to enable AP3216C sensor: %d\n", status);
+		OSA_ERROR("Failed to enable ICM20608 sensor: %d\n", status);
 		return status;
 	}
 
+	if (spi->irq > 0) {
+		status = request_threaded_irq(spi->irq, pdm_sensor_icm20608_irq_timestamp, pdm_sensor_icm20608_irq_handler,
+					      IRQF_ONESHOT, dev_name(&client->dev), client);
+		if (status) {
+			OSA_WARN("Failed to request irq %d: %d, wake-on-motion disabled\n", spi->irq, status);
+		} else {
+			sensor_priv->set_wom = pdm_sensor_icm20608_set_wom;
+		}
+	}
+
 	OSA_DEBUG("PDM SENSOR Setup: %s\n", dev_name(&client->dev));
 
 	return 0;
 }
 
+/**
+ * @brief Leaves wake-on-motion mode and releases the interrupt.
+ */
+static void pdm_sensor_icm20608_cleanup(struct pdm_client *client)
+{
+	struct pdm_sensor_priv *sensor_priv = pdm_client_get_private_data(client);
+
+	if (sensor_priv && sensor_priv->set_wom) {
+		pdm_sensor_icm20608_write_reg(client, ICM20_INT_ENABLE, 0x00);
+		free_irq(client->hardware.spi.spidev->irq, client);
+		sensor_priv->set_wom = NULL;
+	}
+}
+
 const struct pdm_client_match_data pdm_sensor_icm20608_match_data = {
 	.setup = pdm_sensor_icm20608_setup,
-	.cleanup = NULL,
+	.cleanup = pdm_sensor_icm20608_cleanup,
 };
-
@@ -5,6 +5,8 @@
 #define ICM20608D_ID			0XAE	/* ID值 */
 
 #define PDM_SENSOR_ICM20608_RW_LEN	(0x02)
+#define PDM_SENSOR_ICM20608_BURST_MAX	(14)	/* 单次连续读取的最大数据长度(加速度+温度+陀螺仪) */
+#define PDM_SENSOR_ICM20608_READ_FLAG	(0x80)	/* 地址最高位置1为读 */
 
 /* ICM20608寄存器
  *复位后所有寄存器地址都为0，除了
@@ -70,6 +72,29 @@
 #define	ICM20_FIFO_R_W			0x74
 #define	ICM20_WHO_AM_I 			0x75
 
+/* 寄存器位定义 */
+#define	ICM20_PWR_MGMT_1_RESET		0x80	/* 复位 */
+#define	ICM20_PWR_MGMT_1_CYCLE		0x20	/* 加速度计低功耗循环模式 */
+#define	ICM20_PWR_MGMT_1_CLKSEL_AUTO	0x01	/* 自动选择时钟源 */
+#define	ICM20_PWR_MGMT_2_DISABLE_GYRO	0x07	/* 关闭陀螺仪三轴 */
+#define	ICM20_ACCEL_CONFIG2_FCHOICE_B	0x08	/* 旁路加速度计DLPF */
+#define	ICM20_INT_WOM_MASK		0xE0	/* X/Y/Z轴运动唤醒中断 */
+#define	ICM20_INT_WOM_SHIFT		5
+#define	ICM20_ACCEL_INTEL_EN		0x80	/* 使能运动检测 */
+#define	ICM20_ACCEL_INTEL_MODE		0x40	/* 与前一次采样比较 */
+#define	ICM20_WOM_THR_MG_PER_LSB	4	/* 运动阈值 4mg/LSB */
+#define	ICM20_FS_SEL_SHIFT		3	/* 量程选择位偏移 */
+#define	ICM20_FS_SEL_MAX		3
+#define	ICM20_DLPF_CFG_MAX		7
+#define	ICM20_SMPLRT_DIV_MAX		0xFF
+
+/* 默认配置: 1kHz输出, 陀螺仪±2000dps, 加速度计±16G, 低通约20Hz */
+#define	ICM20_DEFAULT_SMPLRT_DIV	0
+#define	ICM20_DEFAULT_GYRO_RANGE	3
+#define	ICM20_DEFAULT_ACCEL_RANGE	3
+#define	ICM20_DEFAULT_GYRO_DLPF		4
+#define	ICM20_DEFAULT_ACCEL_DLPF	4
+
 /* 加速度静态偏移 */
 #define	ICM20_XA_OFFSET_H		0x77
 #define	ICM20_XA_OFFSET_L		0x78
@@ -78,6 +103,18 @@
 #define	ICM20_ZA_OFFSET_H		0x7D
 #define	ICM20_ZA_OFFSET_L 		0x7E
 
+/**
+ * @struct pdm_sensor_icm20608_data
+ * @brief ICM20608 driver private data
+ */
+struct pdm_sensor_icm20608_data {
+	struct mutex xfer_lock;			/**< Protects the transfer buffers */
+	u8 *tx;					/**< DMA-safe transmit buffer, address + data */
+	u8 *rx;					/**< DMA-safe receive buffer */
+	struct pdm_sensor_imu_config config;	/**< Active measurement configuration */
+	bool wom;				/**< Wake-on-motion mode active */
+	u64 irq_timestamp;			/**< CLOCK_BOOTTIME ns of the last INT assertion */
+};
 
 #endif /* _PDM_SENSOR_ICM20608_H_ */
 
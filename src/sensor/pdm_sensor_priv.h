@@ -9,7 +9,10 @@
  * used to manage and operate PDM SENSOR devices.
  */
 
+#include <linux/workqueue.h>
+
 #include "pdm.h"
+#include "pdm_sensor_ioctl.h"
 
 /**
  * @def PDM_SENSOR_NAME
@@ -23,6 +26,32 @@ enum pdm_sensor_command {
 	PDM_SENSOR_CMD_INVALID	= 0xFF
 };
 
+/**
+ * @def PDM_SENSOR_CHANNEL_MAX
+ * @brief Number of channels tracked per sensor, indexed by enum pdm_sensor_type
+ */
+#define PDM_SENSOR_CHANNEL_MAX		(4)
+
+/**
+ * @def PDM_SENSOR_POLL_INTERVAL_MS
+ * @brief Default software threshold sampling interval
+ */
+#define PDM_SENSOR_POLL_INTERVAL_MS	(100)
+
+/**
+ * @struct pdm_sensor_threshold_state
+ * @brief Threshold configuration and current band of one sensor channel
+ */
+struct pdm_sensor_threshold_state {
+	bool enable;				/**< Threshold armed */
+	bool hardware;				/**< Evaluated by the chip instead of the polling work */
+	bool unmeasured;			/**< Polling found the channel off in the current mode, reported once */
+	unsigned int low;			/**< Lower band edge */
+	unsigned int high;			/**< Upper band edge */
+	unsigned int hysteresis;		/**< Hysteresis applied when leaving a band */
+	enum pdm_sensor_threshold_zone zone;	/**< Current band */
+};
+
 /**
  * @struct pdm_sensor_priv
  * @brief PDM SENSOR Device Private Data Structure
@@ -31,9 +60,40 @@ enum pdm_sensor_command {
  * operation functions.
  */
 struct pdm_sensor_priv {
-	int (*read)(struct pdm_client *client, unsigned int type, unsigned int *val);
+	struct pdm_client *client;
+	struct mutex lock;
+	struct delayed_work poll_work;
+	unsigned int poll_interval_ms;
+	struct pdm_sensor_threshold_state thresholds[PDM_SENSOR_CHANNEL_MAX];
+	bool wom_enabled;
+	void *hw_priv;				/**< Sensor driver private data */
+	/* Read one sample, @timestamp is CLOCK_BOOTTIME ns taken at the bus transfer that latched it */
+	int (*read)(struct pdm_client *client, unsigned int type, unsigned int *val, u64 *timestamp);
+	/* Optional: program a hardware window [low, high], -EOPNOTSUPP if the channel has none */
+	int (*set_window)(struct pdm_client *client, unsigned int type, unsigned int low, unsigned int high);
+	/* Optional: enter or leave wake-on-motion mode */
+	int (*set_wom)(struct pdm_client *client, const struct pdm_sensor_wom_config *config);
+	/* Optional: IMU rate, range and filter configuration */
+	int (*set_imu_config)(struct pdm_client *client, const struct pdm_sensor_imu_config *config);
+	int (*get_imu_config)(struct pdm_client *client, struct pdm_sensor_imu_config *config);
+	/* Optional: operating mode selection, see enum pdm_sensor_mode */
+	int (*set_mode)(struct pdm_client *client, unsigned int mode);
+	int (*get_mode)(struct pdm_client *client, unsigned int *mode);
 };
 
+/**
+ * @brief Feeds a fresh sample into the threshold evaluator.
+ *
+ * Updates the channel band, reprograms the hardware window if any and queues a
+ * PDM_CLIENT_EVENT_THRESHOLD event when the band changed. Must be called from process context.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param type Sensor channel.
+ * @param value Sample value.
+ * @param timestamp CLOCK_BOOTTIME ns at which the sample was taken.
+ */
+void pdm_sensor_threshold_report(struct pdm_client *client, unsigned int type, unsigned int value, u64 timestamp);
+
 /**
  * @brief Match data structure for initializing PWM type DIMMER devices.
  */
@@ -1,3 +1,7 @@
+#include <linux/debugfs.h>
+#include <linux/math64.h>
+#include <linux/seq_file.h>
+
 #include "pdm.h"
 #include "pdm_adapter_priv.h"
 #include "pdm_switch_ioctl.h"
@@ -5,6 +9,559 @@
 
 static struct pdm_adapter *switch_adapter = NULL;
 
+/**
+ * @brief Protects the state caches and orders the writes that update them.
+ */
+static DEFINE_MUTEX(pdm_switch_state_lock);
+
+/**
+ * @brief Write-behind banks, protected by pdm_switch_state_lock.
+ */
+static LIST_HEAD(pdm_switch_banks);
+
+/**
+ * @brief Records the timing error of an edge planned for @pulse->next.
+ *
+ * Also records how far the phase the edge ended, on when the line just went off and off
+ * otherwise, was from its requested width.
+ */
+static void pdm_switch_pulse_account(struct pdm_switch_pulse_state *pulse, ktime_t now, bool deferred)
+{
+	u64 err = ktime_after(now, pulse->next) ? ktime_to_ns(ktime_sub(now, pulse->next)) : 0;
+	s64 width = ktime_to_ns(ktime_sub(ktime_sub(now, pulse->last), pulse->state ? pulse->off : pulse->on));
+	u64 width_err = abs(width);
+	unsigned long flags;
+
+	pulse->last = now;
+
+	spin_lock_irqsave(&pulse->stats_lock, flags);
+	pulse->stats.edges++;
+	if (deferred) {
+		pulse->stats.deferred++;
+	}
+	pulse->stats.err_sum_ns += err;
+	pulse->stats.err_max_ns = max(pulse->stats.err_max_ns, err);
+	pulse->stats.err_last_ns = err;
+	pulse->stats.width_err_sum_ns += width_err;
+	pulse->stats.width_err_max_ns = max(pulse->stats.width_err_max_ns, width_err);
+	pulse->stats.width_err_last_ns = width_err;
+	spin_unlock_irqrestore(&pulse->stats_lock, flags);
+}
+
+/**
+ * @brief Plans the edge after the one just driven.
+ *
+ * @return true if another edge is due at @pulse->next, false when the train has completed.
+ */
+static bool pdm_switch_pulse_advance(struct pdm_switch_pulse_state *pulse)
+{
+	if (pulse->state) {
+		pulse->next = ktime_add(pulse->next, pulse->on);
+		return true;
+	}
+
+	pulse->done++;
+	if (pulse->count && pulse->done >= pulse->count) {
+		WRITE_ONCE(pulse->active, false);
+		return false;
+	}
+
+	pulse->next = ktime_add(pulse->next, pulse->off);
+	return true;
+}
+
+static void pdm_switch_pulse_work_func(struct work_struct *work)
+{
+	struct pdm_switch_pulse_state *pulse = container_of(work, struct pdm_switch_pulse_state, work);
+	struct pdm_switch_priv *switch_priv = container_of(pulse, struct pdm_switch_priv, pulse);
+	ktime_t now;
+	int status;
+
+	if (!READ_ONCE(pulse->active)) {
+		return;
+	}
+
+	pulse->state = !pulse->state;
+	status = switch_priv->set_state(switch_priv->client, pulse->state);
+	if (status) {
+		OSA_ERROR("Pulse edge failed on %s: %d\n", dev_name(&switch_priv->client->dev), status);
+		WRITE_ONCE(pulse->active, false);
+		return;
+	}
+	/* The edge is on the line once the write returned, bus latency counts as error */
+	now = ktime_get();
+	pdm_switch_pulse_account(pulse, now, true);
+
+	if (pdm_switch_pulse_advance(pulse)) {
+		hrtimer_start(&pulse->timer, pulse->next, HRTIMER_MODE_ABS);
+	}
+}
+
+static enum hrtimer_restart pdm_switch_pulse_timer_func(struct hrtimer *timer)
+{
+	struct pdm_switch_pulse_state *pulse = container_of(timer, struct pdm_switch_pulse_state, timer);
+	struct pdm_switch_priv *switch_priv = container_of(pulse, struct pdm_switch_priv, pulse);
+	ktime_t now;
+
+	if (!READ_ONCE(pulse->active)) {
+		return HRTIMER_NORESTART;
+	}
+
+	if (!switch_priv->set_state_atomic) {
+		queue_work(system_highpri_wq, &pulse->work);
+		return HRTIMER_NORESTART;
+	}
+
+	pulse->state = !pulse->state;
+	switch_priv->set_state_atomic(switch_priv->client, pulse->state);
+	now = ktime_get();
+	pdm_switch_pulse_account(pulse, now, false);
+
+	if (!pdm_switch_pulse_advance(pulse)) {
+		return HRTIMER_NORESTART;
+	}
+
+	hrtimer_set_expires(timer, pulse->next);
+	return HRTIMER_RESTART;
+}
+
+/**
+ * @brief Stops a running pulse train, the switch keeps its current state.
+ *
+ * Must be called with @switch_priv->pulse_lock held.
+ */
+static void pdm_switch_pulse_stop(struct pdm_switch_priv *switch_priv)
+{
+	struct pdm_switch_pulse_state *pulse = &switch_priv->pulse;
+
+	WRITE_ONCE(pulse->active, false);
+	hrtimer_cancel(&pulse->timer);
+	cancel_work_sync(&pulse->work);
+	/* The work may have re-armed the timer before it saw the train stopped */
+	hrtimer_cancel(&pulse->timer);
+}
+
+/**
+ * @brief Writes a state unless the cache shows it is already committed.
+ *
+ * Must be called with pdm_switch_state_lock held.
+ */
+static int pdm_switch_state_commit(struct pdm_switch_priv *switch_priv, int state)
+{
+	ktime_t expires;
+	int status;
+
+	if (!switch_priv->set_state) {
+		return -ENOTSUPP;
+	}
+
+	if (switch_priv->state_valid && switch_priv->state == state) {
+		switch_priv->cache_stats.sets_elided++;
+		return 0;
+	}
+
+	if (switch_priv->bank) {
+		switch_priv->state = state;
+		switch_priv->state_valid = true;
+		switch_priv->dirty = true;
+		switch_priv->cache_stats.sets_deferred++;
+		/* An hrtimer bounds the delay below a jiffy, pending flushes keep an earlier expiry */
+		expires = ktime_add_us(ktime_get(), switch_priv->wb_delay_us);
+		if (!hrtimer_is_queued(&switch_priv->bank->timer)
+			|| ktime_before(expires, hrtimer_get_expires(&switch_priv->bank->timer))) {
+			hrtimer_start(&switch_priv->bank->timer, expires, HRTIMER_MODE_ABS);
+		}
+		return 0;
+	}
+
+	status = switch_priv->set_state(switch_priv->client, state);
+	switch_priv->state = state;
+	switch_priv->state_valid = !status;
+	return status;
+}
+
+/**
+ * @brief Updates the cache from a state read from the line.
+ *
+ * Must be called with pdm_switch_state_lock held.
+ */
+static void pdm_switch_state_refresh(struct pdm_switch_priv *switch_priv, int state)
+{
+	if (switch_priv->state_valid && switch_priv->state != state) {
+		switch_priv->cache_stats.verify_errors++;
+		OSA_WARN("%s reads %d, %d was set\n", dev_name(&switch_priv->client->dev), state, switch_priv->state);
+	}
+
+	/* Inputs and switches running a pulse train change on their own */
+	switch_priv->state = state;
+	switch_priv->state_valid = switch_priv->set_state && !READ_ONCE(switch_priv->pulse.active);
+}
+
+/**
+ * @brief Returns the cached state, or reads the line when not cached or in verify mode.
+ *
+ * Must be called with pdm_switch_state_lock held.
+ */
+static int pdm_switch_state_read(struct pdm_switch_priv *switch_priv, int *state)
+{
+	int status;
+
+	if (!switch_priv->get_state) {
+		return -ENOTSUPP;
+	}
+
+	/* A deferred state is not on the line yet, reading it back would report the old one */
+	if (switch_priv->state_valid && (!switch_priv->verify || switch_priv->dirty)) {
+		switch_priv->cache_stats.get_hits++;
+		*state = switch_priv->state;
+		return 0;
+	}
+
+	status = switch_priv->get_state(switch_priv->client, state);
+	if (!status) {
+		pdm_switch_state_refresh(switch_priv, *state);
+	}
+	return status;
+}
+
+/**
+ * @brief Writes the dirty members of a write-behind bank.
+ *
+ * The states are collected under the state lock and written without it, so sets of the
+ * members keep returning at once while the bus transfer runs. Sets arriving meanwhile mark
+ * their switch dirty again and are picked up by the next pass.
+ */
+static void pdm_switch_bank_work_func(struct work_struct *work)
+{
+	struct pdm_switch_bank *bank = container_of(work, struct pdm_switch_bank, work);
+	struct pdm_client *batch[PDM_SWITCH_MULTI_MAX];
+	int states[PDM_SWITCH_MULTI_MAX];
+	struct pdm_switch_priv *switch_priv, *first_priv;
+	unsigned int i, n;
+	int status;
+
+	do {
+		n = 0;
+		first_priv = NULL;
+		mutex_lock(&pdm_switch_state_lock);
+		list_for_each_entry(switch_priv, &bank->members, bank_entry) {
+			if (!switch_priv->dirty) {
+				continue;
+			}
+			if (n == PDM_SWITCH_MULTI_MAX) {
+				break;
+			}
+			switch_priv->dirty = false;
+			first_priv = first_priv ? first_priv : switch_priv;
+			batch[n] = switch_priv->client;
+			states[n] = switch_priv->state;
+			n++;
+		}
+		if (n) {
+			bank->flushes++;
+		}
+		mutex_unlock(&pdm_switch_state_lock);
+
+		if (!n) {
+			break;
+		}
+
+		if (first_priv->set_multi) {
+			status = first_priv->set_multi(batch, states, n);
+		}
+		else {
+			for (i = 0, status = 0; i < n && !status; i++) {
+				status = first_priv->set_state(batch[i], states[i]);
+			}
+		}
+
+		if (status) {
+			OSA_ERROR("Write-behind flush of %u switches failed: %d\n", n, status);
+			mutex_lock(&pdm_switch_state_lock);
+			if (!bank->error) {
+				bank->error = status;
+			}
+			/* The line state is unknown, the next set writes again */
+			for (i = 0; i < n; i++) {
+				switch_priv = pdm_client_get_private_data(batch[i]);
+				if (!switch_priv->dirty) {
+					switch_priv->state_valid = false;
+				}
+			}
+			mutex_unlock(&pdm_switch_state_lock);
+		}
+	} while (n == PDM_SWITCH_MULTI_MAX);
+}
+
+static enum hrtimer_restart pdm_switch_bank_timer_func(struct hrtimer *timer)
+{
+	struct pdm_switch_bank *bank = container_of(timer, struct pdm_switch_bank, timer);
+
+	queue_work(system_highpri_wq, &bank->work);
+	return HRTIMER_NORESTART;
+}
+
+/**
+ * @brief Writes the deferred states of a switch's bank and waits for the flush.
+ *
+ * @return Returns 0, or the first flush error of the bank since the last barrier.
+ */
+static int pdm_switch_bank_sync(struct pdm_switch_priv *switch_priv)
+{
+	struct pdm_switch_bank *bank = switch_priv->bank;
+	int status;
+
+	if (!bank) {
+		return 0;
+	}
+
+	hrtimer_cancel(&bank->timer);
+	queue_work(system_highpri_wq, &bank->work);
+	flush_work(&bank->work);
+
+	mutex_lock(&pdm_switch_state_lock);
+	status = bank->error;
+	bank->error = 0;
+	mutex_unlock(&pdm_switch_state_lock);
+
+	return status;
+}
+
+/**
+ * @brief Makes a switch write-behind, joining the bank of its chip.
+ *
+ * Switches whose backend reports no bank are cheap to write and stay synchronous.
+ */
+static int pdm_switch_bank_attach(struct pdm_switch_priv *switch_priv)
+{
+	struct pdm_switch_bank *bank, *new_bank;
+	const void *key;
+
+	if (!switch_priv->get_bank || !switch_priv->set_state) {
+		return 0;
+	}
+
+	key = switch_priv->get_bank(switch_priv->client);
+	if (!key) {
+		return 0;
+	}
+
+	new_bank = kzalloc(sizeof(*new_bank), GFP_KERNEL);
+	if (!new_bank) {
+		return -ENOMEM;
+	}
+
+	mutex_lock(&pdm_switch_state_lock);
+	list_for_each_entry(bank, &pdm_switch_banks, entry) {
+		if (bank->key == key) {
+			goto join;
+		}
+	}
+
+	bank = new_bank;
+	new_bank = NULL;
+	bank->key = key;
+	INIT_LIST_HEAD(&bank->members);
+	INIT_WORK(&bank->work, pdm_switch_bank_work_func);
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 13, 0)
+	hrtimer_init(&bank->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	bank->timer.function = pdm_switch_bank_timer_func;
+#else
+	hrtimer_setup(&bank->timer, pdm_switch_bank_timer_func, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+#endif
+	list_add_tail(&bank->entry, &pdm_switch_banks);
+
+join:
+	bank->refs++;
+	list_add_tail(&switch_priv->bank_entry, &bank->members);
+	switch_priv->bank = bank;
+	mutex_unlock(&pdm_switch_state_lock);
+
+	kfree(new_bank);
+	return 0;
+}
+
+/**
+ * @brief Leaves the write-behind bank, freeing it with its last member.
+ *
+ * Deferred states of the switch are dropped, the caller turns it off anyway.
+ */
+static void pdm_switch_bank_detach(struct pdm_switch_priv *switch_priv)
+{
+	struct pdm_switch_bank *bank = switch_priv->bank;
+	bool last;
+
+	if (!bank) {
+		return;
+	}
+
+	mutex_lock(&pdm_switch_state_lock);
+	list_del(&switch_priv->bank_entry);
+	switch_priv->dirty = false;
+	switch_priv->bank = NULL;
+	last = !--bank->refs;
+	if (last) {
+		list_del(&bank->entry);
+	}
+	mutex_unlock(&pdm_switch_state_lock);
+
+	/* A flush running now may still write this switch */
+	if (last) {
+		hrtimer_cancel(&bank->timer);
+		cancel_work_sync(&bank->work);
+		kfree(bank);
+	}
+	else {
+		flush_work(&bank->work);
+	}
+}
+
+/**
+ * @brief Starts a pulse train, replacing the one running.
+ *
+ * The first edge is driven before returning, the rest are timed from it.
+ *
+ * @param client Pointer to the PDM client structure.
+ * @param req Pulse train to generate.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_switch_pulse_start(struct pdm_client *client, const struct pdm_switch_pulse *req)
+{
+	struct pdm_switch_priv *switch_priv = pdm_client_get_private_data(client);
+	struct pdm_switch_pulse_state *pulse = &switch_priv->pulse;
+	unsigned long flags;
+	int status;
+
+	if (req->on_us < PDM_SWITCH_PULSE_MIN_US || (req->count != 1 && req->off_us < PDM_SWITCH_PULSE_MIN_US)) {
+		OSA_ERROR("Invalid pulse: on %u us, off %u us\n", req->on_us, req->off_us);
+		return -EINVAL;
+	}
+
+	if (!switch_priv->set_state) {
+		OSA_ERROR("set_state not supported\n");
+		return -ENOTSUPP;
+	}
+
+	mutex_lock(&switch_priv->pulse_lock);
+	pdm_switch_pulse_stop(switch_priv);
+
+	pulse->on = us_to_ktime(req->on_us);
+	pulse->off = us_to_ktime(req->off_us);
+	pulse->count = req->count;
+	pulse->done = 0;
+	/* Deferred states must not land on the line in the middle of the train */
+	pdm_switch_bank_sync(switch_priv);
+
+	/* The train owns the line, the cache is refilled by the next get or set */
+	mutex_lock(&pdm_switch_state_lock);
+	switch_priv->state_valid = false;
+	status = switch_priv->set_state(client, 1);
+	mutex_unlock(&pdm_switch_state_lock);
+	if (status) {
+		OSA_ERROR("PDM Switch set_state failed, status: %d\n", status);
+		goto unlock;
+	}
+
+	spin_lock_irqsave(&pulse->stats_lock, flags);
+	pulse->stats.trains++;
+	spin_unlock_irqrestore(&pulse->stats_lock, flags);
+
+	/* The on phase is timed from the moment the first edge reached the line */
+	pulse->state = 1;
+	pulse->last = ktime_get();
+	pulse->next = ktime_add(pulse->last, pulse->on);
+	WRITE_ONCE(pulse->active, true);
+	hrtimer_start(&pulse->timer, pulse->next, HRTIMER_MODE_ABS);
+
+	OSA_DEBUG("Pulse started on %s: on %u us, off %u us, count %u\n", dev_name(&client->dev),
+		  req->on_us, req->off_us, req->count);
+unlock:
+	mutex_unlock(&switch_priv->pulse_lock);
+	return status;
+}
+
+/**
+ * @brief Cancels a running pulse train and turns the switch off.
+ */
+static int pdm_switch_pulse_cancel(struct pdm_client *client)
+{
+	struct pdm_switch_priv *switch_priv = pdm_client_get_private_data(client);
+	int status = 0;
+
+	mutex_lock(&switch_priv->pulse_lock);
+	pdm_switch_pulse_stop(switch_priv);
+	if (switch_priv->pulse.state && switch_priv->set_state) {
+		mutex_lock(&pdm_switch_state_lock);
+		status = pdm_switch_state_commit(switch_priv, 0);
+		mutex_unlock(&pdm_switch_state_lock);
+		if (!status) {
+			switch_priv->pulse.state = 0;
+		}
+	}
+	mutex_unlock(&switch_priv->pulse_lock);
+
+	return status;
+}
+
+static void pdm_switch_pulse_init(struct pdm_switch_priv *switch_priv)
+{
+	struct pdm_switch_pulse_state *pulse = &switch_priv->pulse;
+
+	mutex_init(&switch_priv->pulse_lock);
+	spin_lock_init(&pulse->stats_lock);
+	INIT_WORK(&pulse->work, pdm_switch_pulse_work_func);
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 13, 0)
+	hrtimer_init(&pulse->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	pulse->timer.function = pdm_switch_pulse_timer_func;
+#else
+	hrtimer_setup(&pulse->timer, pdm_switch_pulse_timer_func, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+#endif
+}
+
+/**
+ * @brief Shows the pulse edge timing statistics of a switch.
+ */
+static int pdm_switch_stats_show(struct seq_file *s, void *data)
+{
+	struct pdm_client *client = s->private;
+	struct pdm_switch_priv *switch_priv = pdm_client_get_private_data(client);
+	struct pdm_switch_pulse_stats stats;
+	unsigned long flags;
+
+	spin_lock_irqsave(&switch_priv->pulse.stats_lock, flags);
+	stats = switch_priv->pulse.stats;
+	spin_unlock_irqrestore(&switch_priv->pulse.stats_lock, flags);
+
+	seq_printf(s, "pulse_mode:    %s\n", switch_priv->set_state_atomic ? "hrtimer" : "work");
+	seq_printf(s, "pulse_active:  %d\n", READ_ONCE(switch_priv->pulse.active));
+	seq_printf(s, "pulse_trains:  %llu\n", stats.trains);
+	seq_printf(s, "pulse_edges:   %llu\n", stats.edges);
+	seq_printf(s, "pulse_deferred: %llu\n", stats.deferred);
+	seq_printf(s, "edge_err_avg:  %llu ns\n", stats.edges ? div64_u64(stats.err_sum_ns, stats.edges) : 0);
+	seq_printf(s, "edge_err_max:  %llu ns\n", stats.err_max_ns);
+	seq_printf(s, "edge_err_last: %llu ns\n", stats.err_last_ns);
+	seq_printf(s, "width_err_avg: %llu ns\n", stats.edges ? div64_u64(stats.width_err_sum_ns, stats.edges) : 0);
+	seq_printf(s, "width_err_max: %llu ns\n", stats.width_err_max_ns);
+	seq_printf(s, "width_err_last: %llu ns\n", stats.width_err_last_ns);
+
+	mutex_lock(&pdm_switch_state_lock);
+	seq_printf(s, "state_cached:  %s\n", switch_priv->state_valid ? (switch_priv->state ? "on" : "off") : "no");
+	seq_printf(s, "verify:        %d\n", switch_priv->verify);
+	seq_printf(s, "get_hits:      %llu\n", switch_priv->cache_stats.get_hits);
+	seq_printf(s, "sets_elided:   %llu\n", switch_priv->cache_stats.sets_elided);
+	seq_printf(s, "verify_errors: %llu\n", switch_priv->cache_stats.verify_errors);
+	seq_printf(s, "sets_deferred: %llu\n", switch_priv->cache_stats.sets_deferred);
+	if (switch_priv->bank) {
+		seq_printf(s, "write_behind:  %u us\n", switch_priv->wb_delay_us);
+		seq_printf(s, "bank_members:  %u\n", switch_priv->bank->refs);
+		seq_printf(s, "bank_flushes:  %llu\n", switch_priv->bank->flushes);
+	}
+	mutex_unlock(&pdm_switch_state_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(pdm_switch_stats);
+
 
 /**
  * @brief Sets the state of a specified PDM SWITCH device.
@@ -34,7 +591,12 @@ static int pdm_switch_set_state(struct pdm_client *client, int state)
 		return -ENOTSUPP;
 	}
 
-	status = switch_priv->set_state(client, state);
+	mutex_lock(&switch_priv->pulse_lock);
+	pdm_switch_pulse_stop(switch_priv);
+	mutex_lock(&pdm_switch_state_lock);
+	status = pdm_switch_state_commit(switch_priv, !!state);
+	mutex_unlock(&pdm_switch_state_lock);
+	mutex_unlock(&switch_priv->pulse_lock);
 	if (status) {
 		OSA_ERROR("PDM Switch set_state failed, status: %d\n", status);
 		return status;
@@ -71,7 +633,9 @@ static int pdm_switch_get_state(struct pdm_client *client, int *state)
 		return -ENOTSUPP;
 	}
 
-	status = switch_priv->get_state(client, state);
+	mutex_lock(&pdm_switch_state_lock);
+	status = pdm_switch_state_read(switch_priv, state);
+	mutex_unlock(&pdm_switch_state_lock);
 	if (status) {
 		OSA_ERROR("PDM Switch get_state failed, status: %d\n", status);
 		return status;
@@ -81,6 +645,137 @@ static int pdm_switch_get_state(struct pdm_client *client, int *state)
 	return 0;
 }
 
+/**
+ * @brief Sets or reads several switches.
+ *
+ * The clients are resolved under the client list lock, which is held throughout. Switches
+ * already in the requested state, or whose state is cached, are not accessed. The others
+ * sharing a backend with bulk access are handled in one backend call, the rest one by one.
+ *
+ * @param multi Switches to access, states and per-entry status are filled in.
+ * @param set true to set the states, false to read them.
+ * @return Returns 0 on success; negative error code on failure.
+ */
+static int pdm_switch_multi(struct pdm_switch_multi *multi, bool set)
+{
+	struct pdm_client *clients[PDM_SWITCH_MULTI_MAX];
+	struct pdm_client *batch[PDM_SWITCH_MULTI_MAX];
+	unsigned int slots[PDM_SWITCH_MULTI_MAX];
+	int states[PDM_SWITCH_MULTI_MAX];
+	struct pdm_switch_priv *switch_priv, *first_priv;
+	struct pdm_client *client;
+	unsigned int i, j, n;
+	bool bulk;
+	int status;
+
+	if (!multi->count || multi->count > PDM_SWITCH_MULTI_MAX) {
+		OSA_ERROR("Invalid switch count: %u\n", multi->count);
+		return -EINVAL;
+	}
+
+	mutex_lock(&switch_adapter->client_list_mutex_lock);
+	for (i = 0; i < multi->count; i++) {
+		clients[i] = NULL;
+		multi->entries[i].status = -ENODEV;
+		list_for_each_entry(client, &switch_adapter->client_list, entry) {
+			if (client->index == multi->entries[i].index) {
+				clients[i] = client;
+				multi->entries[i].status = 0;
+				break;
+			}
+		}
+	}
+
+	/* An explicit state overrides running pulse trains */
+	for (i = 0; set && i < multi->count; i++) {
+		if (clients[i]) {
+			switch_priv = pdm_client_get_private_data(clients[i]);
+			mutex_lock(&switch_priv->pulse_lock);
+			pdm_switch_pulse_stop(switch_priv);
+			mutex_unlock(&switch_priv->pulse_lock);
+		}
+	}
+
+	mutex_lock(&pdm_switch_state_lock);
+	for (i = 0; i < multi->count; i++) {
+		if (!clients[i]) {
+			continue;
+		}
+
+		switch_priv = pdm_client_get_private_data(clients[i]);
+		if (set) {
+			multi->entries[i].state = !!multi->entries[i].state;
+			if (switch_priv->bank
+			    || (switch_priv->state_valid && switch_priv->state == multi->entries[i].state)) {
+				/* Elided, or deferred to the bank flush */
+				multi->entries[i].status = pdm_switch_state_commit(switch_priv, multi->entries[i].state);
+				clients[i] = NULL;
+			}
+		}
+		else if (switch_priv->state_valid && (!switch_priv->verify || switch_priv->dirty)) {
+			switch_priv->cache_stats.get_hits++;
+			multi->entries[i].state = switch_priv->state;
+			clients[i] = NULL;
+		}
+	}
+
+	for (i = 0; i < multi->count; i++) {
+		if (!clients[i]) {
+			continue;
+		}
+
+		/* Collect the remaining switches of the same backend into one batch */
+		first_priv = pdm_client_get_private_data(clients[i]);
+		n = 0;
+		for (j = i; j < multi->count; j++) {
+			if (!clients[j]) {
+				continue;
+			}
+			switch_priv = pdm_client_get_private_data(clients[j]);
+			if (j == i || (set ? (first_priv->set_multi && switch_priv->set_multi == first_priv->set_multi)
+					   : (first_priv->get_multi && switch_priv->get_multi == first_priv->get_multi))) {
+				batch[n] = clients[j];
+				slots[n] = j;
+				states[n] = multi->entries[j].state;
+				n++;
+				clients[j] = NULL;
+			}
+		}
+
+		if (set) {
+			status = first_priv->set_multi ? first_priv->set_multi(batch, states, n)
+						       : pdm_switch_state_commit(first_priv, states[0]);
+		} else {
+			status = first_priv->get_multi ? first_priv->get_multi(batch, states, n)
+						       : pdm_switch_state_read(first_priv, &states[0]);
+		}
+
+		for (j = 0; j < n; j++) {
+			multi->entries[slots[j]].status = status;
+			if (!set && !status) {
+				multi->entries[slots[j]].state = states[j];
+			}
+		}
+
+		/* Bulk accesses bypass the per-switch helpers, update the caches here */
+		bulk = set ? !!first_priv->set_multi : !!first_priv->get_multi;
+		for (j = 0; bulk && j < n; j++) {
+			switch_priv = pdm_client_get_private_data(batch[j]);
+			if (set) {
+				switch_priv->state = states[j];
+				switch_priv->state_valid = !status;
+			}
+			else if (!status) {
+				pdm_switch_state_refresh(switch_priv, states[j]);
+			}
+		}
+	}
+	mutex_unlock(&pdm_switch_state_lock);
+	mutex_unlock(&switch_adapter->client_list_mutex_lock);
+
+	return 0;
+}
+
 /**
  * @brief Handles IOCTL commands from user space.
  *
@@ -92,6 +787,8 @@ static int pdm_switch_get_state(struct pdm_client *client, int *state)
 static long pdm_switch_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
 	struct pdm_client *client = filp->private_data;
+	struct pdm_switch_multi *multi;
+	struct pdm_switch_pulse pulse;
 	int status = 0;
 
 	if (!client) {
@@ -124,6 +821,42 @@ static long pdm_switch_ioctl(struct file *filp, unsigned int cmd, unsigned long
 			}
 			break;
 		}
+		case PDM_SWITCH_MULTI_SET:
+		case PDM_SWITCH_MULTI_GET:
+		{
+			multi = memdup_user((void __user *)arg, sizeof(*multi));
+			if (IS_ERR(multi)) {
+				OSA_ERROR("Failed to copy data from user space\n");
+				return PTR_ERR(multi);
+			}
+
+			status = pdm_switch_multi(multi, cmd == PDM_SWITCH_MULTI_SET);
+			if (!status && copy_to_user((void __user *)arg, multi, sizeof(*multi))) {
+				OSA_ERROR("Failed to copy data to user space\n");
+				status = -EFAULT;
+			}
+			kfree(multi);
+			break;
+		}
+		case PDM_SWITCH_PULSE:
+		{
+			if (copy_from_user(&pulse, (void __user *)arg, sizeof(pulse))) {
+				OSA_ERROR("Failed to copy data from user space\n");
+				return -EFAULT;
+			}
+			status = pdm_switch_pulse_start(client, &pulse);
+			break;
+		}
+		case PDM_SWITCH_PULSE_CANCEL:
+		{
+			status = pdm_switch_pulse_cancel(client);
+			break;
+		}
+		case PDM_SWITCH_FLUSH:
+		{
+			status = pdm_switch_bank_sync(pdm_client_get_private_data(client));
+			break;
+		}
 		default:
 		{
 			OSA_ERROR("Unknown ioctl command\n");
@@ -151,12 +884,18 @@ static long pdm_switch_ioctl(struct file *filp, unsigned int cmd, unsigned long
  */
 static ssize_t pdm_switch_read(struct file *filp, char __user *buf, size_t count, loff_t *ppos)
 {
+	struct pdm_client *client = filp->private_data;
 	const char help_info[] =
 		"Available commands:\n"
 		" > 1 <0|1>	- Set SWITCH state\n"
 		" > 2		- Get current SWITCH state\n";
 	size_t len = strlen(help_info);
 
+	/* Input switches report their edges */
+	if (client && pdm_client_event_enabled(client)) {
+		return pdm_client_event_read(client, filp, buf, count);
+	}
+
 	if (*ppos >= len)
 		return 0;
 
@@ -267,7 +1006,9 @@ size_t count, loff_t *ppos)
  */
 static int pdm_switch_device_probe(struct pdm_device *pdmdev)
 {
+	struct pdm_switch_priv *switch_priv;
 	struct pdm_client *client;
+	struct device_node *np;
 	int status;
 
 	client = devm_pdm_client_alloc(pdmdev, sizeof(struct pdm_switch_priv));
@@ -276,6 +1017,10 @@ static int pdm_switch_device_probe(struct pdm_device *pdmdev)
 		return PTR_ERR(client);
 	}
 
+	switch_priv = pdm_client_get_private_data(client);
+	switch_priv->client = client;
+	pdm_switch_pulse_init(switch_priv);
+
 	status = devm_pdm_client_register(switch_adapter, client);
 	if (status) {
 		OSA_ERROR("SWITCH Adapter Add Device Failed, status=%d\n", status);
@@ -288,6 +1033,25 @@ static int pdm_switch_device_probe(struct pdm_device *pdmdev)
 		return status;
 	}
 
+	/* Verify mode reads every get back from the line, for switches that may be changed behind our back */
+	np = pdm_client_get_of_node(client);
+	switch_priv->verify = of_property_read_bool(np, "verify-state");
+
+	if (of_property_read_bool(np, "write-behind")) {
+		if (of_property_read_u32(np, "write-behind-delay-us", &switch_priv->wb_delay_us)) {
+			switch_priv->wb_delay_us = PDM_SWITCH_WRITE_BEHIND_US;
+		}
+		status = pdm_switch_bank_attach(switch_priv);
+		if (status) {
+			OSA_ERROR("SWITCH Write-behind Setup Failed, status=%d\n", status);
+			pdm_client_cleanup(client);
+			return status;
+		}
+	}
+
+	switch_priv->debugfs = debugfs_create_file(dev_name(&client->dev), 0444, pdm_debugfs_get_dir(),
+						   client, &pdm_switch_stats_fops);
+
 	client->fops.read = pdm_switch_read;
 	client->fops.write = pdm_switch_write;
 	client->fops.unlocked_ioctl = pdm_switch_ioctl;
@@ -304,7 +1068,16 @@ static int pdm_switch_device_probe(struct pdm_device *pdmdev)
  */
 static void pdm_switch_device_remove(struct pdm_device *pdmdev)
 {
+	struct pdm_switch_priv *switch_priv;
+
 	if (pdmdev && pdmdev->client) {
+		switch_priv = pdm_client_get_private_data(pdmdev->client);
+		debugfs_remove(switch_priv->debugfs);
+		mutex_lock(&switch_priv->pulse_lock);
+		pdm_switch_pulse_stop(switch_priv);
+		mutex_unlock(&switch_priv->pulse_lock);
+		pdm_switch_bank_detach(switch_priv);
+		pdm_client_event_enable(pdmdev->client, false);
 		pdm_client_cleanup(pdmdev->client);
 	}
 }
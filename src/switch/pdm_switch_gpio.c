@@ -1,9 +1,28 @@
 #include <linux/of_gpio.h>
 #include <linux/gpio.h>
+#include <linux/gpio/driver.h>
+#include <linux/interrupt.h>
 
 #include "pdm.h"
+#include "pdm_switch_ioctl.h"
 #include "pdm_switch_priv.h"
 
+#define PDM_SWITCH_GPIO_DEBOUNCE_MS	(5)	/* Default input debounce interval (ms) */
+
+/**
+ * @brief Input mode state of a GPIO switch.
+ */
+struct pdm_switch_gpio_input {
+	struct pdm_client *client;
+	int irq;
+	bool hw_debounce;		/* Debounced by the GPIO controller, no timer needed */
+	ktime_t debounce;		/* Software debounce interval */
+	struct hrtimer timer;		/* Restarted on every edge, expires once the line is stable */
+	struct work_struct work;	/* Samples the line after the debounce interval */
+	unsigned long pending;		/* Bit 0 set while an edge waits to be reported */
+	u64 timestamp;			/* CLOCK_BOOTTIME ns of the first edge of the burst */
+	int state;			/* Last reported state */
+};
 
 static bool pdm_switch_gpio_level_to_state(struct gpio_desc *gpiod, int level)
 {
@@ -52,6 +71,17 @@ static int pdm_switch_gpio_set_state(struct pdm_client *client, int state)
 	return 0;
 }
 
+/**
+ * @brief Sets the state of a GPIO SWITCH that does not sleep, callable from any context.
+ */
+static int pdm_switch_gpio_set_state_atomic(struct pdm_client *client, int state)
+{
+	struct gpio_desc *gpiod = client->hardware.gpio.gpiod;
+
+	gpiod_set_value(gpiod, pdm_switch_gpio_state_to_level(gpiod, state));
+	return 0;
+}
+
 static int pdm_switch_gpio_get_state(struct pdm_client *client, int *state)
 {
 	struct gpio_desc *gpiod;
@@ -70,6 +100,247 @@ static int pdm_switch_gpio_get_state(struct pdm_client *client, int *state)
 	return 0;
 }
 
+/**
+ * @brief Sets several GPIO switches with one gpiolib call.
+ *
+ * gpiolib groups the descriptors by chip, so the switches of one expander are written in
+ * a single bus transaction where the chip supports set_multiple.
+ */
+static int pdm_switch_gpio_set_multi(struct pdm_client **clients, const int *states, unsigned int count)
+{
+	struct gpio_desc *descs[PDM_SWITCH_MULTI_MAX];
+	DECLARE_BITMAP(values, PDM_SWITCH_MULTI_MAX);
+	unsigned int i;
+
+	if (count > PDM_SWITCH_MULTI_MAX) {
+		return -EINVAL;
+	}
+
+	bitmap_zero(values, PDM_SWITCH_MULTI_MAX);
+	for (i = 0; i < count; i++) {
+		descs[i] = clients[i]->hardware.gpio.gpiod;
+		__assign_bit(i, values, pdm_switch_gpio_state_to_level(descs[i], states[i]));
+	}
+
+	return gpiod_set_array_value_cansleep(count, descs, NULL, values);
+}
+
+/**
+ * @brief Reads several GPIO switches with one gpiolib call.
+ */
+static int pdm_switch_gpio_get_multi(struct pdm_client **clients, int *states, unsigned int count)
+{
+	struct gpio_desc *descs[PDM_SWITCH_MULTI_MAX];
+	DECLARE_BITMAP(values, PDM_SWITCH_MULTI_MAX);
+	unsigned int i;
+	int status;
+
+	if (count > PDM_SWITCH_MULTI_MAX) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < count; i++) {
+		descs[i] = clients[i]->hardware.gpio.gpiod;
+	}
+
+	status = gpiod_get_array_value_cansleep(count, descs, NULL, values);
+	if (status) {
+		return status;
+	}
+
+	for (i = 0; i < count; i++) {
+		states[i] = pdm_switch_gpio_level_to_state(descs[i], test_bit(i, values));
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Returns the chip of a GPIO switch behind a sleeping bus, used to group deferred writes.
+ */
+static const void *pdm_switch_gpio_get_bank(struct pdm_client *client)
+{
+	struct gpio_desc *gpiod = client->hardware.gpio.gpiod;
+
+	if (!gpiod_cansleep(gpiod)) {
+		return NULL;
+	}
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 7, 0)
+	return gpiod_to_chip(gpiod);
+#else
+	return gpiod_to_gpio_device(gpiod);
+#endif
+}
+
+/**
+ * @brief Returns the debounced state of an input switch.
+ */
+static int pdm_switch_gpio_input_get_state(struct pdm_client *client, int *state)
+{
+	struct pdm_switch_priv *switch_priv = pdm_client_get_private_data(client);
+	struct pdm_switch_gpio_input *input = switch_priv->hw_priv;
+
+	*state = READ_ONCE(input->state);
+	return 0;
+}
+
+/**
+ * @brief Samples the line and queues an event when the state changed.
+ *
+ * Runs in process context, the GPIO may sit behind a sleeping bus.
+ */
+static void pdm_switch_gpio_input_report(struct pdm_switch_gpio_input *input)
+{
+	struct pdm_client *client = input->client;
+	struct pdm_client_event event = {0};
+	int value;
+
+	/* An edge arriving while sampling starts a new burst and is reported again */
+	event.timestamp = READ_ONCE(input->timestamp);
+	clear_bit(0, &input->pending);
+	value = gpiod_get_value_cansleep(client->hardware.gpio.gpiod);
+	if (value < 0) {
+		OSA_WARN("Failed to read %s: %d\n", dev_name(&client->dev), value);
+		return;
+	}
+
+	/* Same level to state mapping as the output side */
+	value = pdm_switch_gpio_level_to_state(client->hardware.gpio.gpiod, value);
+	if (value == input->state) {
+		return;
+	}
+	WRITE_ONCE(input->state, value);
+
+	event.type = PDM_CLIENT_EVENT_SWITCH;
+	event.value = value;
+	pdm_client_event_push(client, &event);
+}
+
+static void pdm_switch_gpio_input_work_func(struct work_struct *work)
+{
+	struct pdm_switch_gpio_input *input = container_of(work, struct pdm_switch_gpio_input, work);
+
+	pdm_switch_gpio_input_report(input);
+}
+
+static enum hrtimer_restart pdm_switch_gpio_input_timer_func(struct hrtimer *timer)
+{
+	struct pdm_switch_gpio_input *input = container_of(timer, struct pdm_switch_gpio_input, timer);
+
+	queue_work(system_highpri_wq, &input->work);
+	return HRTIMER_NORESTART;
+}
+
+/**
+ * @brief Edge interrupt, timestamps the burst and restarts the debounce timer.
+ */
+static irqreturn_t pdm_switch_gpio_input_irq(int irq, void *data)
+{
+	struct pdm_switch_gpio_input *input = data;
+
+	if (!test_and_set_bit(0, &input->pending)) {
+		WRITE_ONCE(input->timestamp, ktime_get_boottime_ns());
+	}
+
+	if (input->hw_debounce) {
+		return IRQ_WAKE_THREAD;
+	}
+
+	hrtimer_start(&input->timer, input->debounce, HRTIMER_MODE_REL);
+	return IRQ_HANDLED;
+}
+
+/**
+ * @brief Threaded part of the edge interrupt.
+ *
+ * Interrupts of GPIO expanders are nested into the parent's thread and never run the
+ * primary handler, so the edge is timestamped and debounced here as well.
+ */
+static irqreturn_t pdm_switch_gpio_input_irq_thread(int irq, void *data)
+{
+	struct pdm_switch_gpio_input *input = data;
+
+	if (!test_and_set_bit(0, &input->pending)) {
+		WRITE_ONCE(input->timestamp, ktime_get_boottime_ns());
+	}
+
+	if (!input->hw_debounce) {
+		hrtimer_start(&input->timer, input->debounce, HRTIMER_MODE_REL);
+		return IRQ_HANDLED;
+	}
+
+	pdm_switch_gpio_input_report(input);
+	return IRQ_HANDLED;
+}
+
+/**
+ * @brief Sets up an input switch: debounce, edge interrupt and event reporting.
+ *
+ * The controller debounce is used when it supports the requested interval, otherwise every
+ * edge restarts an hrtimer and the line is sampled once it has been stable for the interval.
+ */
+static int pdm_switch_gpio_input_setup(struct pdm_client *client, struct device_node *np)
+{
+	struct pdm_switch_priv *switch_priv = pdm_client_get_private_data(client);
+	struct gpio_desc *gpiod = client->hardware.gpio.gpiod;
+	struct pdm_switch_gpio_input *input;
+	unsigned int debounce_ms;
+	int status;
+
+	input = devm_kzalloc(&client->pdmdev->dev, sizeof(*input), GFP_KERNEL);
+	if (!input) {
+		OSA_ERROR("Failed to allocate input switch data\n");
+		return -ENOMEM;
+	}
+
+	if (of_property_read_u32(np, "debounce-interval", &debounce_ms)) {
+		debounce_ms = PDM_SWITCH_GPIO_DEBOUNCE_MS;
+	}
+
+	input->client = client;
+	input->debounce = ms_to_ktime(debounce_ms);
+	input->hw_debounce = !debounce_ms || !gpiod_set_debounce(gpiod, debounce_ms * USEC_PER_MSEC);
+	INIT_WORK(&input->work, pdm_switch_gpio_input_work_func);
+#if LINUX_VERSION_CODE < KERNEL_VERSION(6, 13, 0)
+	hrtimer_init(&input->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	input->timer.function = pdm_switch_gpio_input_timer_func;
+#else
+	hrtimer_setup(&input->timer, pdm_switch_gpio_input_timer_func, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+#endif
+
+	status = gpiod_get_value_cansleep(gpiod);
+	if (status < 0) {
+		OSA_ERROR("Failed to read input: %d\n", status);
+		return status;
+	}
+	input->state = pdm_switch_gpio_level_to_state(gpiod, status);
+
+	input->irq = gpiod_to_irq(gpiod);
+	if (input->irq < 0) {
+		OSA_ERROR("GPIO has no interrupt: %d\n", input->irq);
+		return input->irq;
+	}
+
+	switch_priv->hw_priv = input;
+	switch_priv->get_state = pdm_switch_gpio_input_get_state;
+	pdm_client_event_enable(client, true);
+
+	status = request_threaded_irq(input->irq, pdm_switch_gpio_input_irq, pdm_switch_gpio_input_irq_thread,
+				      IRQF_TRIGGER_RISING | IRQF_TRIGGER_FALLING | IRQF_ONESHOT,
+				      dev_name(&client->dev), input);
+	if (status) {
+		OSA_ERROR("Failed to request irq %d: %d\n", input->irq, status);
+		pdm_client_event_enable(client, false);
+		switch_priv->hw_priv = NULL;
+		return status;
+	}
+
+	OSA_DEBUG("GPIO SWITCH input: %s, %s debounce %u ms\n", dev_name(&client->dev),
+		  input->hw_debounce ? "hardware" : "software", debounce_ms);
+	return 0;
+}
+
 /**
  * @brief Initializes GPIO settings for a PDM device.
  *
@@ -84,6 +355,7 @@ static int pdm_switch_gpio_setup(struct pdm_client *client)
 	struct device_node *np;
 	struct gpio_desc *gpiod;
 	const char *default_state_str;
+	const char *mode_str;
 	int default_state;
 	int gpio_level;
 	int status;
@@ -99,15 +371,34 @@ static int pdm_switch_gpio_setup(struct pdm_client *client)
 		return -ENOMEM;
 	}
 
-	switch_priv->set_state = pdm_switch_gpio_set_state;
-	switch_priv->get_state = pdm_switch_gpio_get_state;
-
 	np = pdm_client_get_of_node(client);
 	if (!np) {
 		OSA_ERROR("No DT node found\n");
 		return -EINVAL;
 	}
 
+	if (!of_property_read_string(np, "switch-mode", &mode_str) && !strcmp(mode_str, "input")) {
+		gpiod = gpiod_get_index(client->pdmdev->dev.parent, NULL, 0, GPIOD_IN);
+		if (IS_ERR(gpiod)) {
+			OSA_ERROR("Failed to get GPIO\n");
+			return PTR_ERR(gpiod);
+		}
+
+		client->hardware.gpio.gpiod = gpiod;
+		status = pdm_switch_gpio_input_setup(client, np);
+		if (status) {
+			gpiod_put(gpiod);
+			client->hardware.gpio.gpiod = NULL;
+		}
+		return status;
+	}
+
+	switch_priv->set_state = pdm_switch_gpio_set_state;
+	switch_priv->get_state = pdm_switch_gpio_get_state;
+	switch_priv->set_multi = pdm_switch_gpio_set_multi;
+	switch_priv->get_multi = pdm_switch_gpio_get_multi;
+	switch_priv->get_bank = pdm_switch_gpio_get_bank;
+
 	status = of_property_read_string(np, "default-state", &default_state_str);
 	if (!status && !strcmp(default_state_str, "on")) {
 		default_state = 1;
@@ -126,6 +417,9 @@ static int pdm_switch_gpio_setup(struct pdm_client *client)
 	gpiod_set_value_cansleep(gpiod, gpio_level);
 
 	client->hardware.gpio.gpiod = gpiod;
+	if (!gpiod_cansleep(gpiod)) {
+		switch_priv->set_state_atomic = pdm_switch_gpio_set_state_atomic;
+	}
 
 	OSA_DEBUG("GPIO SWITCH Setup: %s\n", dev_name(&client->dev));
 	return 0;
@@ -133,14 +427,25 @@ static int pdm_switch_gpio_setup(struct pdm_client *client)
 
 static void pdm_switch_gpio_cleanup(struct pdm_client *client)
 {
+	struct pdm_switch_priv *switch_priv;
+	struct pdm_switch_gpio_input *input;
 	struct gpio_desc *gpiod;
 
-	if (!client && IS_ERR_OR_NULL(client->hardware.gpio.gpiod)) {
+	if (!client || IS_ERR_OR_NULL(client->hardware.gpio.gpiod)) {
 		return;
 	}
 
+	switch_priv = pdm_client_get_private_data(client);
+	input = switch_priv ? switch_priv->hw_priv : NULL;
 	gpiod = client->hardware.gpio.gpiod;
-	gpiod_set_value_cansleep(gpiod, pdm_switch_gpio_state_to_level(gpiod, 0));
+	if (input) {
+		free_irq(input->irq, input);
+		hrtimer_cancel(&input->timer);
+		cancel_work_sync(&input->work);
+	}
+	else {
+		gpiod_set_value_cansleep(gpiod, pdm_switch_gpio_state_to_level(gpiod, 0));
+	}
 	gpiod_put(client->hardware.gpio.gpiod);
 	OSA_DEBUG("GPIO SWITCH Cleanup: %s\n", dev_name(&client->dev));
 }
@@ -9,6 +9,11 @@
  * used to manage and operate PDM SWITCH devices.
  */
 
+#include <linux/hrtimer.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
 #include "pdm.h"
 
 /**
@@ -24,6 +29,80 @@ enum pdm_switch_command {
 	PDM_SWITCH_CMD_INVALID		= 0xFF
 };
 
+#define PDM_SWITCH_PULSE_MIN_US		(10)		/* Shortest accepted on or off time */
+#define PDM_SWITCH_WRITE_BEHIND_US	(1000)		/* Default flush delay of write-behind switches */
+
+/**
+ * @struct pdm_switch_pulse_stats
+ * @brief Pulse edge timing statistics, exported through debugfs
+ *
+ * The error of an edge is the delay between its planned time and the moment it was driven.
+ * The width error is the difference between the achieved on or off time, measured between
+ * two consecutive driven edges, and the requested one.
+ */
+struct pdm_switch_pulse_stats {
+	u64 trains;				/**< Pulse trains started */
+	u64 edges;				/**< Timed edges driven */
+	u64 deferred;				/**< Edges driven from the work item */
+	u64 err_sum_ns;				/**< Sum of edge errors */
+	u64 err_max_ns;				/**< Largest edge error */
+	u64 err_last_ns;			/**< Error of the last edge */
+	u64 width_err_sum_ns;			/**< Sum of width errors */
+	u64 width_err_max_ns;			/**< Largest width error */
+	u64 width_err_last_ns;			/**< Width error of the last phase */
+};
+
+/**
+ * @struct pdm_switch_pulse_state
+ * @brief In-kernel pulse train generator
+ *
+ * Edges are planned on absolute times from the start of the train, so the errors do not
+ * accumulate. Backends that can switch atomically are driven from the hrtimer, the others
+ * from a work item.
+ */
+struct pdm_switch_pulse_state {
+	struct hrtimer timer;			/**< Next edge */
+	struct work_struct work;		/**< Drives the edge when the backend may sleep */
+	ktime_t on;				/**< On time */
+	ktime_t off;				/**< Off time */
+	ktime_t next;				/**< Planned time of the next edge */
+	ktime_t last;				/**< Time the last edge was driven */
+	unsigned int count;			/**< Pulses requested, 0 forever */
+	unsigned int done;			/**< Pulses completed */
+	int state;				/**< State driven by the last edge */
+	bool active;				/**< Train running */
+	spinlock_t stats_lock;			/**< Protects @stats, updated from the hrtimer */
+	struct pdm_switch_pulse_stats stats;	/**< Edge timing statistics */
+};
+
+/**
+ * @struct pdm_switch_cache_stats
+ * @brief State cache statistics, exported through debugfs
+ */
+struct pdm_switch_cache_stats {
+	u64 get_hits;				/**< Gets served without reading the line */
+	u64 sets_elided;			/**< Sets skipped since the state was already committed */
+	u64 verify_errors;			/**< Read-backs that differed from the cached state */
+	u64 sets_deferred;			/**< Sets left to the bank flush */
+};
+
+/**
+ * @struct pdm_switch_bank
+ * @brief Write-behind switches sharing a chip
+ *
+ * Sets of the members only update their cached state, the flush work writes all dirty
+ * members with bulk accesses. Members are linked and marked dirty under the adapter state lock.
+ */
+struct pdm_switch_bank {
+	struct list_head entry;			/**< Node in the adapter bank list */
+	const void *key;			/**< Chip identifier returned by get_bank */
+	struct list_head members;		/**< Member switches */
+	unsigned int refs;			/**< Number of members */
+	struct hrtimer timer;			/**< Expires at the earliest flush deadline, queues @work */
+	struct work_struct work;		/**< Flushes the dirty members */
+	int error;				/**< First flush error since the last barrier */
+	u64 flushes;				/**< Bulk writes issued */
+};
 
 /**
  * @struct pdm_switch_priv
@@ -33,8 +112,31 @@ enum pdm_switch_command {
  * operation functions.
  */
 struct pdm_switch_priv {
+	struct pdm_client *client;
+	struct mutex pulse_lock;		/**< Serializes pulse train start and stop */
+	struct pdm_switch_pulse_state pulse;	/**< Pulse generator */
+	int state;				/**< Committed output state, valid if @state_valid */
+	bool state_valid;			/**< @state matches the line */
+	bool verify;				/**< Gets read the line back instead of trusting @state */
+	struct pdm_switch_bank *bank;		/**< Write-behind bank, NULL if sets are synchronous */
+	struct list_head bank_entry;		/**< Node in the bank member list */
+	unsigned int wb_delay_us;		/**< Longest delay of a deferred set */
+	bool dirty;				/**< @state waits for the bank flush */
+	struct pdm_switch_cache_stats cache_stats;	/**< State cache statistics */
+	struct dentry *debugfs;			/**< Statistics file */
 	int (*set_state)(struct pdm_client *client, int state);
+	/* Optional: set_state callable from hrtimer context, for switches that never sleep */
+	int (*set_state_atomic)(struct pdm_client *client, int state);
 	int (*get_state)(struct pdm_client *client, int *state);
+	/*
+	 * Optional: access several switches of the same backend in one call, @clients all use
+	 * this backend. Per-switch results are not available, the return value applies to all.
+	 */
+	int (*set_multi)(struct pdm_client **clients, const int *states, unsigned int count);
+	int (*get_multi)(struct pdm_client **clients, int *states, unsigned int count);
+	/* Optional: identifies the chip of a switch whose writes sleep, NULL if writes are cheap */
+	const void *(*get_bank)(struct pdm_client *client);
+	void *hw_priv;		/* Backend private data */
 };
 
 /**